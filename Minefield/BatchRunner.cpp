@@ -0,0 +1,247 @@
+#include "stdafx.h"
+#include "BatchRunner.h"
+#include "Logger.h"
+#include "QueryPerformanceTimer.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    /// <summary>
+    /// Returns value at percentile aPercent of sorted samples, nearest rank.
+    /// </summary>
+    int GetPercentile(const std::vector<int>& aSortedSamples, const int aPercent)
+    {
+        if (aSortedSamples.empty())
+        {
+            return 0;
+        }
+
+        const size_t rank((aSortedSamples.size() * aPercent + 99) / 100);
+
+        return aSortedSamples[std::min(aSortedSamples.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+
+    /// <summary>
+    /// Logs min, median, p90, max and mean of samples.
+    /// </summary>
+    void PrintDistribution(const char* aName, std::vector<int> aSamples)
+    {
+        std::sort(aSamples.begin(), aSamples.end());
+
+        double total(0.0);
+
+        for (const int sample : aSamples)
+        {
+            total += sample;
+        }
+
+        LOG_MESSAGE(LL_SUMMARY, "Batch %s: min %d, median %d, p90 %d, max %d, mean %.2f\n", aName, aSamples.empty() ? 0 : aSamples.front(),
+            GetPercentile(aSamples, 50), GetPercentile(aSamples, 90), aSamples.empty() ? 0 : aSamples.back(),
+            aSamples.empty() ? 0.0 : total / aSamples.size());
+    }
+}
+
+BatchRunner::BatchRunner() :
+    m_nextGame(0),
+    m_pOutput(NULL),
+    m_time(0.0)
+{
+}
+
+BatchRunner::~BatchRunner()
+{
+}
+
+bool BatchRunner::Run(const BatchSettings& aSettings, const char* aOutputPath)
+{
+    m_settings = aSettings;
+    m_results.assign(std::max(0, aSettings.m_numberOfSeeds), BatchGameResult());
+    m_nextGame = 0;
+    m_time = 0.0;
+
+    if (NULL != aOutputPath)
+    {
+        m_pOutput = fopen(aOutputPath, "w");
+
+        if (NULL == m_pOutput)
+        {
+            m_error = std::string("cannot open '") + aOutputPath + "'";
+            return false;
+        }
+
+        fprintf(m_pOutput, "seed,winner,turns,milliseconds");
+
+        for (int team = 0; team < aSettings.m_numberOfTeams; team++)
+        {
+            fprintf(m_pOutput, ",team%d", team);
+        }
+
+        fprintf(m_pOutput, "\n");
+    }
+
+    QueryPerformanceTimer timer;
+    timer.Start();
+
+    {
+        const int numberOfThreads(std::max(1, std::min(aSettings.m_numberOfThreads, aSettings.m_numberOfSeeds)));
+        std::vector<std::thread> threads;
+
+        for (int thread = 1; thread < numberOfThreads; thread++)
+        {
+            threads.emplace_back(&BatchRunner::PlayGames, this);
+        }
+
+        /* Calling thread plays too */
+        PlayGames();
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    m_time = timer.Get() / 1000.0;
+
+    if (NULL != m_pOutput)
+    {
+        const bool written(0 == ferror(m_pOutput));
+
+        if (0 != fclose(m_pOutput) || !written)
+        {
+            m_pOutput = NULL;
+            m_error = std::string("cannot write '") + aOutputPath + "'";
+            return false;
+        }
+
+        m_pOutput = NULL;
+    }
+
+    return true;
+}
+
+void BatchRunner::PlayGames(void)
+{
+    /* Kept for every game of this thread, Dispose keeps its allocations */
+    MineManager manager;
+    WorkerPool inlinePool;
+
+    manager.SetTargetingBackend(m_settings.m_targetingBackend);
+    manager.SetIncrementalTargeting(m_settings.m_incrementalTargeting);
+    manager.SetTargetListMode(m_settings.m_targetListMode);
+    inlinePool.Start(0);
+
+    for (int game = m_nextGame++; game < m_settings.m_numberOfSeeds; game = m_nextGame++)
+    {
+        BatchGameResult& result(m_results[game]);
+        QueryPerformanceTimer timer;
+
+        timer.Start();
+
+        manager.Dispose();
+        manager.SetRandomSeed(m_settings.m_firstSeed + static_cast<unsigned int>(game));
+        manager.Init(m_settings.m_numberOfTeams, m_settings.m_numberOfMinesPerTeam);
+
+        Simulation simulation(manager, inlinePool, m_settings.m_numberOfTeams);
+
+        simulation.SpawnMines(m_settings.m_numberOfMinesPerTeam, m_settings.m_distribution, m_settings.m_useHashIDs);
+
+        while (simulation.RunTurn())
+        {
+        }
+
+        result.m_seed = manager.GetRandomSeed();
+        result.m_numberOfTurns = simulation.GetNumberOfTurns();
+        result.m_minesPerTeam.resize(m_settings.m_numberOfTeams);
+
+        for (int team = 0; team < m_settings.m_numberOfTeams; team++)
+        {
+            result.m_minesPerTeam[team] = manager.GetNumberOfObjectForTeam(team);
+        }
+
+        result.m_winningTeam = Simulation::GetWinningTeam(result.m_minesPerTeam);
+        result.m_time = timer.Get() / 1000.0;
+
+        WriteResult(result);
+    }
+
+    manager.Dispose();
+}
+
+void BatchRunner::WriteResult(const BatchGameResult& aResult)
+{
+    if (NULL == m_pOutput)
+    {
+        return;
+    }
+
+    /* Formatted outside the lock, lines land in completion order */
+    std::string line;
+    char text[64];
+
+    snprintf(text, sizeof(text), "%u,%d,%d,%.3f", aResult.m_seed, aResult.m_winningTeam, aResult.m_numberOfTurns, aResult.m_time);
+    line += text;
+
+    for (const int mines : aResult.m_minesPerTeam)
+    {
+        snprintf(text, sizeof(text), ",%d", mines);
+        line += text;
+    }
+
+    line += "\n";
+
+    std::lock_guard<std::mutex> lock(m_outputLock);
+
+    fputs(line.c_str(), m_pOutput);
+}
+
+void BatchRunner::PrintSummary(void) const
+{
+    const int numberOfGames(static_cast<int>(m_results.size()));
+    std::vector<int> turns;
+    std::vector<int> winnerMines;
+    std::vector<int> survivors;
+    double gameTime(0.0);
+
+    for (const BatchGameResult& result : m_results)
+    {
+        int total(0);
+
+        for (const int mines : result.m_minesPerTeam)
+        {
+            total += mines;
+        }
+
+        turns.push_back(result.m_numberOfTurns);
+        winnerMines.push_back(result.m_minesPerTeam.empty() ? 0 : result.m_minesPerTeam[result.m_winningTeam]);
+        survivors.push_back(total);
+        gameTime += result.m_time;
+    }
+
+    LOG_MESSAGE(LL_SUMMARY, "Batch played %d games in %.3f ms, %.1f games per second, %.3f ms per game\n", numberOfGames, m_time,
+        m_time > 0.0 ? numberOfGames * 1000.0 / m_time : 0.0, 0 < numberOfGames ? gameTime / numberOfGames : 0.0);
+
+    for (int team = 0; team < m_settings.m_numberOfTeams; team++)
+    {
+        int wins(0);
+        std::vector<int> remaining;
+
+        for (const BatchGameResult& result : m_results)
+        {
+            wins += team == result.m_winningTeam ? 1 : 0;
+            remaining.push_back(result.m_minesPerTeam[team]);
+        }
+
+        LOG_MESSAGE(LL_SUMMARY, "Batch team %d wins %d games (%.1f%%)\n", team, wins, 0 < numberOfGames ? 100.0 * wins / numberOfGames : 0.0);
+
+        char name[32];
+
+        snprintf(name, sizeof(name), "team %d mines remaining", team);
+        PrintDistribution(name, remaining);
+    }
+
+    PrintDistribution("turns", turns);
+    PrintDistribution("winner mines remaining", winnerMines);
+    PrintDistribution("mines remaining", survivors);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Simulation.h"
+#include "MineManager.h"
+#include "SpatialIndex.h"
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Seed range and game a batch plays.
+/// </summary>
+struct BatchSettings
+{
+    unsigned int m_firstSeed;
+    int m_numberOfSeeds;
+    /* Games played at once, each on a thread of its own */
+    int m_numberOfThreads;
+    int m_numberOfTeams;
+    int m_numberOfMinesPerTeam;
+    SpawnDistribution m_distribution;
+    TargetingBackend m_targetingBackend;
+    bool m_incrementalTargeting;
+    TargetListMode m_targetListMode;
+    bool m_useHashIDs;
+};
+
+/// <summary>
+/// Outcome of one game of a batch.
+/// </summary>
+struct BatchGameResult
+{
+    unsigned int m_seed;
+    int m_winningTeam;
+    int m_numberOfTurns;
+    /* Milliseconds, building the field included */
+    double m_time;
+    std::vector<int> m_minesPerTeam;
+};
+
+/// <summary>
+/// Monte Carlo batch: plays one game per seed of a range, several at once, all in this process. Every
+/// thread owns a MineManager and plays its games one after the other on it, so storage, views and
+/// spatial index allocations are reused from game to game; games run their jobs inline, seeds being
+/// the unit of parallelism. Results are streamed to an optional CSV file as games finish, one line
+/// per seed, and aggregated into win rates, turn counts and survivor distributions.
+/// </summary>
+class BatchRunner
+{
+public:
+    BatchRunner(void);
+    ~BatchRunner(void);
+
+    /// <summary>
+    /// Plays every seed and waits for them.
+    /// </summary>
+    /// <param name="aSettings">const BatchSettings&. Seeds and game</param>
+    /// <param name="aOutputPath">const char*. CSV file receiving one line per game, NULL for none</param>
+    /// <returns>bool. False if output file cannot be written, see GetError</returns>
+    bool Run(const BatchSettings& aSettings, const char* aOutputPath);
+    /// <summary>
+    /// Logs win rates, turn counts and survivor distributions of the last Run.
+    /// </summary>
+    void PrintSummary(void) const;
+    /// <summary>
+    /// Returns results of the last Run, in seed order.
+    /// </summary>
+    /// <returns>const std::vector<BatchGameResult>&. One result per seed</returns>
+    inline const std::vector<BatchGameResult>& GetResults(void) const { return m_results; }
+    /// <summary>
+    /// Returns why Run failed.
+    /// </summary>
+    /// <returns>const char*. Reason</returns>
+    inline const char* GetError(void) const { return m_error.c_str(); }
+
+private:
+    /// <summary>
+    /// Thread body: takes the next seed until none is left.
+    /// </summary>
+    void PlayGames(void);
+    /// <summary>
+    /// Writes a result line to the output file, if any.
+    /// </summary>
+    /// <param name="aResult">const BatchGameResult&. Finished game</param>
+    void WriteResult(const BatchGameResult& aResult);
+
+    BatchSettings m_settings;
+    /* Indexed by seed offset, each entry written by the thread playing it */
+    std::vector<BatchGameResult> m_results;
+    std::atomic<int> m_nextGame;
+    FILE* m_pOutput;
+    std::mutex m_outputLock;
+    /* Wall time of the last Run, milliseconds */
+    double m_time;
+    std::string m_error;
+};
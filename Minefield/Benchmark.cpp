@@ -0,0 +1,604 @@
+//
+// Minefield benchmark
+//
+// Plays complete games over every combination of teams, mines per team, worker threads, spawn
+// distribution and radius distribution, timing setup, targeting, selection and explosion phases separately. Each combination
+// is played a few untimed warmup games, then a number of timed repetitions, and the median, 90th and
+// 99th percentile of every phase are written as JSON or CSV so runs can be compared over time.
+//
+// Usage: minefield-benchmark [--teams=5,10] [--mines=500,1500] [--threads=1,4] [--distribution=uniform,sparse]
+//                            [--radii=uniform,small,large,bimodal] [--warmup=1] [--repetitions=5] [--seed=654321] [--targeting=grid]
+//                            [--target-lists=full|count] [--format=json|csv] [--output=path] [--perf-counters=on|off]
+//
+// With --perf-counters=on, hardware counters of the targeting and explosion phases are added, as a
+// mean per game, when the machine exposes them.
+//
+// Before the sweep every SIMD level of the distance kernel is checked against the scalar one with
+// query radii placed exactly on a position, where any rounding difference would change the matches.
+//
+#include "stdafx.h"
+#include "DistanceKernel.h"
+#include "MineManager.h"
+#include "Simulation.h"
+#include "Logger.h"
+#include "PerfCounters.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    /* Sum of every phase, reported next to them */
+    const int cTotalPhase = SP_COUNT;
+    const char* const cTotalPhaseName = "total";
+    /* Distance kernel check: queries, positions per query, enough for full registers plus a tail, and coordinate range */
+    const int cKernelCheckQueries = 100000;
+    const int cKernelCheckPositions = 61;
+    const float cKernelCheckExtent = 5000.0f;
+
+    /// <summary>
+    /// One combination of the sweep and the phase times of its timed repetitions.
+    /// </summary>
+    struct BenchmarkCase
+    {
+        int m_numberOfTeams;
+        int m_numberOfMinesPerTeam;
+        int m_numberOfThreads;
+        SpawnDistribution m_distribution;
+        RadiusDistribution m_radiusDistribution;
+        int m_numberOfTurns;
+        /* Milliseconds, one entry per repetition, indexed by SimulationPhase then cTotalPhase */
+        std::vector<double> m_samples[SP_COUNT + 1];
+        /* Counters added up over the timed repetitions */
+        PerfCounterValues m_counters[SP_COUNT];
+    };
+
+    /// <summary>
+    /// Summary of the samples of one phase.
+    /// </summary>
+    struct PhaseStatistics
+    {
+        double m_min;
+        double m_median;
+        double m_p90;
+        double m_p99;
+        double m_max;
+    };
+
+    /// <summary>
+    /// Returns value of a "--aName=value" command line option, NULL if aArg is a different option.
+    /// </summary>
+    const char* GetOptionValue(const char* aArg, const char* aName)
+    {
+        const size_t nameLength(strlen(aName));
+
+        return (0 == strncmp(aArg, "--", 2) && 0 == strncmp(aArg + 2, aName, nameLength) && '=' == aArg[2 + nameLength]) ? aArg + 3 + nameLength : NULL;
+    }
+
+    /// <summary>
+    /// Parses a comma separated list of positive integers.
+    /// </summary>
+    /// <returns>bool. False if an entry is not a positive integer</returns>
+    bool ParseIntegerList(const char* aValue, std::vector<int>& aList)
+    {
+        aList.clear();
+
+        while ('\0' != *aValue)
+        {
+            char* end(NULL);
+            const long value(strtol(aValue, &end, 10));
+
+            if (end == aValue || value <= 0 || (',' != *end && '\0' != *end))
+            {
+                return false;
+            }
+
+            aList.push_back(static_cast<int>(value));
+            aValue = ',' == *end ? end + 1 : end;
+        }
+
+        return !aList.empty();
+    }
+
+    /// <summary>
+    /// Parses a comma separated list of names with aParse (Simulation::ParseDistribution and the like).
+    /// </summary>
+    /// <returns>bool. False if a name is unknown</returns>
+    template<typename TValue>
+    bool ParseNameList(const char* aValue, bool (*aParse)(const char*, TValue&), std::vector<TValue>& aList)
+    {
+        aList.clear();
+
+        while ('\0' != *aValue)
+        {
+            const char* end(strchr(aValue, ','));
+            const size_t length(NULL != end ? static_cast<size_t>(end - aValue) : strlen(aValue));
+            char name[32];
+            TValue value = TValue();
+
+            if (length >= sizeof(name))
+            {
+                return false;
+            }
+
+            memcpy(name, aValue, length);
+            name[length] = '\0';
+
+            if (!aParse(name, value))
+            {
+                return false;
+            }
+
+            aList.push_back(value);
+            aValue = NULL != end ? end + 1 : aValue + length;
+        }
+
+        return !aList.empty();
+    }
+
+    /// <summary>
+    /// Returns nearest rank percentile of sorted samples.
+    /// </summary>
+    double GetPercentile(const std::vector<double>& aSorted, const double aPercentile)
+    {
+        const size_t rank(static_cast<size_t>(aPercentile / 100.0 * aSorted.size() + 0.999999));
+
+        return aSorted[std::min(std::max<size_t>(rank, 1), aSorted.size()) - 1];
+    }
+
+    /// <summary>
+    /// Summarizes samples of one phase.
+    /// </summary>
+    PhaseStatistics GetStatistics(std::vector<double> aSamples)
+    {
+        PhaseStatistics statistics = {};
+
+        if (!aSamples.empty())
+        {
+            std::sort(aSamples.begin(), aSamples.end());
+
+            const size_t middle(aSamples.size() / 2);
+
+            statistics.m_min = aSamples.front();
+            statistics.m_median = 0 == aSamples.size() % 2 ? (aSamples[middle - 1] + aSamples[middle]) / 2.0 : aSamples[middle];
+            statistics.m_p90 = GetPercentile(aSamples, 90.0);
+            statistics.m_p99 = GetPercentile(aSamples, 99.0);
+            statistics.m_max = aSamples.back();
+        }
+
+        return statistics;
+    }
+
+    /// <summary>
+    /// Sets the squared query radius to exactly the Vector3::SqrDistance of one of the positions and checks
+    /// every supported SIMD level reports the same matches as the scalar kernel. Active level is restored.
+    /// </summary>
+    /// <param name="aSeed">unsigned int. Random seed</param>
+    /// <returns>bool. False if a level disagrees, the first disagreement is printed</returns>
+    bool CheckDistanceKernel(const unsigned int aSeed)
+    {
+        const SimdLevel activeLevel(DistanceKernel::GetLevel());
+        float x[cKernelCheckPositions];
+        float y[cKernelCheckPositions];
+        float z[cKernelCheckPositions];
+        std::vector<int> expected;
+        std::vector<int> matches;
+        bool valid(true);
+
+        for (int query = 0; valid && query < cKernelCheckQueries; query++)
+        {
+            for (int i = 0; i < cKernelCheckPositions; i++)
+            {
+                x[i] = (GetCounterRandomFloat32(aSeed, query, i, 0) * 2.0f - 1.0f) * cKernelCheckExtent;
+                y[i] = (GetCounterRandomFloat32(aSeed, query, i, 1) * 2.0f - 1.0f) * cKernelCheckExtent;
+                z[i] = (GetCounterRandomFloat32(aSeed, query, i, 2) * 2.0f - 1.0f) * cKernelCheckExtent;
+            }
+
+            const int boundary(static_cast<int>(GetCounterRandomUInt32(aSeed, query, cKernelCheckPositions, 0) % cKernelCheckPositions));
+            const Vector3 center(x[boundary] + (GetCounterRandomFloat32(aSeed, query, cKernelCheckPositions, 1) * 2.0f - 1.0f) * cKernelCheckExtent,
+                                 y[boundary] + (GetCounterRandomFloat32(aSeed, query, cKernelCheckPositions, 2) * 2.0f - 1.0f) * cKernelCheckExtent,
+                                 z[boundary] + (GetCounterRandomFloat32(aSeed, query, cKernelCheckPositions, 3) * 2.0f - 1.0f) * cKernelCheckExtent);
+            const float sqrRadius(Vector3::SqrDistance(Vector3(x[boundary], y[boundary], z[boundary]), center));
+
+            expected.clear();
+            DistanceKernel::SetLevel(SL_SCALAR);
+            DistanceKernel::AppendInRadius(x, y, z, NULL, cKernelCheckPositions, center, sqrRadius, NULL, 0, expected);
+
+            for (int level = SL_SCALAR + 1; valid && level <= DistanceKernel::GetSupportedLevel(); level++)
+            {
+                matches.clear();
+                DistanceKernel::SetLevel(static_cast<SimdLevel>(level));
+                DistanceKernel::AppendInRadius(x, y, z, NULL, cKernelCheckPositions, center, sqrRadius, NULL, 0, matches);
+
+                if (matches != expected)
+                {
+                    fprintf(stderr, "Distance kernel %s disagrees with scalar on query %d: %d matches instead of %d\n",
+                        DistanceKernel::GetLevelName(static_cast<SimdLevel>(level)), query, static_cast<int>(matches.size()), static_cast<int>(expected.size()));
+                    valid = false;
+                }
+            }
+        }
+
+        DistanceKernel::SetLevel(activeLevel);
+
+        return valid;
+    }
+
+    /// <summary>
+    /// Plays one complete game on a clean manager.
+    /// </summary>
+    /// <param name="aCase">const BenchmarkCase&. Combination to play</param>
+    /// <param name="aPool">WorkerPool&. Started pool</param>
+    /// <param name="aSeed">unsigned int. Random seed</param>
+    /// <param name="aTargetingBackend">TargetingBackend. Backend answering targeting queries</param>
+    /// <param name="aPhaseTimes">double*. Receives milliseconds spent per phase, SP_COUNT + 1 entries</param>
+    /// <returns>int. Number of turns played</returns>
+    int PlayGame(const BenchmarkCase& aCase, WorkerPool& aPool, const unsigned int aSeed, const TargetingBackend aTargetingBackend, double* aPhaseTimes)
+    {
+        MineManager& manager(MineManager::GetInstance());
+
+        manager.Dispose();
+        manager.SetTargetingBackend(aTargetingBackend);
+        manager.SetRadiusDistribution(aCase.m_radiusDistribution);
+        manager.Init(aCase.m_numberOfTeams, aCase.m_numberOfMinesPerTeam);
+
+        SetRandomSeed(aSeed);
+        manager.SetRandomSeed(aSeed);
+
+        Simulation simulation(manager, aPool, aCase.m_numberOfTeams);
+
+        simulation.SpawnMines(aCase.m_numberOfMinesPerTeam, aCase.m_distribution, false);
+
+        while (simulation.RunTurn())
+        {
+        }
+
+        aPhaseTimes[cTotalPhase] = 0.0;
+
+        for (int phase = 0; phase < SP_COUNT; phase++)
+        {
+            aPhaseTimes[phase] = simulation.GetPhaseTime(static_cast<SimulationPhase>(phase)) / 1000.0;
+            aPhaseTimes[cTotalPhase] += aPhaseTimes[phase];
+        }
+
+        return simulation.GetNumberOfTurns();
+    }
+
+    /// <summary>
+    /// Returns name of a phase, cTotalPhase included.
+    /// </summary>
+    const char* GetPhaseName(const int aPhase)
+    {
+        return cTotalPhase == aPhase ? cTotalPhaseName : Simulation::GetPhaseName(static_cast<SimulationPhase>(aPhase));
+    }
+
+    /// <summary>
+    /// Returns if counters were collected for a phase.
+    /// </summary>
+    bool HasCounters(const int aPhase)
+    {
+        return PerfCounters::IsEnabled() && (SP_TARGETING == aPhase || SP_EXPLOSION == aPhase);
+    }
+
+    /// <summary>
+    /// Returns counter name usable as a CSV column or JSON key, spaces replaced by underscores.
+    /// </summary>
+    const char* GetCounterKey(const int aCounter, char* aText, const size_t aSize)
+    {
+        snprintf(aText, aSize, "%s", PerfCounters::GetCounterName(static_cast<PerfCounter>(aCounter)));
+        std::replace(aText, aText + strlen(aText), ' ', '_');
+
+        return aText;
+    }
+
+    /// <summary>
+    /// Formats mean per game of a counter, aEmpty if it was not collected.
+    /// </summary>
+    const char* FormatCounter(const BenchmarkCase& aCase, const int aPhase, const int aCounter, const char* aEmpty, char* aText, const size_t aSize)
+    {
+        if (!HasCounters(aPhase) || !aCase.m_counters[aPhase].m_available[aCounter])
+        {
+            return aEmpty;
+        }
+
+        snprintf(aText, aSize, "%llu", aCase.m_counters[aPhase].m_value[aCounter] / aCase.m_samples[aPhase].size());
+        return aText;
+    }
+
+    /// <summary>
+    /// Writes one row per case and phase.
+    /// </summary>
+    void WriteCsv(FILE* aFile, const std::vector<BenchmarkCase>& aCases, const TargetingBackend aTargetingBackend, const TargetListMode aTargetListMode)
+    {
+        fprintf(aFile, "teams,mines_per_team,threads,distribution,radii,targeting,target_lists,turns,phase,repetitions,min_ms,median_ms,p90_ms,p99_ms,max_ms");
+
+        for (int counter = 0; counter < PC_COUNT; counter++)
+        {
+            char name[32];
+
+            fprintf(aFile, ",%s", GetCounterKey(counter, name, sizeof(name)));
+        }
+
+        fprintf(aFile, "\n");
+
+        for (const BenchmarkCase& benchmarkCase : aCases)
+        {
+            for (int phase = 0; phase <= cTotalPhase; phase++)
+            {
+                const PhaseStatistics statistics(GetStatistics(benchmarkCase.m_samples[phase]));
+
+                fprintf(aFile, "%d,%d,%d,%s,%s,%s,%s,%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f", benchmarkCase.m_numberOfTeams, benchmarkCase.m_numberOfMinesPerTeam,
+                    benchmarkCase.m_numberOfThreads, Simulation::GetDistributionName(benchmarkCase.m_distribution),
+                    MineManager::GetRadiusDistributionName(benchmarkCase.m_radiusDistribution), SpatialIndex::GetBackendName(aTargetingBackend),
+                    MineManager::GetTargetListModeName(aTargetListMode), benchmarkCase.m_numberOfTurns, GetPhaseName(phase), static_cast<int>(benchmarkCase.m_samples[phase].size()),
+                    statistics.m_min, statistics.m_median, statistics.m_p90, statistics.m_p99, statistics.m_max);
+
+                for (int counter = 0; counter < PC_COUNT; counter++)
+                {
+                    char text[32];
+
+                    fprintf(aFile, ",%s", FormatCounter(benchmarkCase, phase, counter, "", text, sizeof(text)));
+                }
+
+                fprintf(aFile, "\n");
+            }
+        }
+    }
+
+    /// <summary>
+    /// Writes run settings and one object per case, holding the statistics of every phase.
+    /// </summary>
+    void WriteJson(FILE* aFile, const std::vector<BenchmarkCase>& aCases, const TargetingBackend aTargetingBackend, const TargetListMode aTargetListMode,
+                   const unsigned int aSeed, const int aWarmup, const int aRepetitions)
+    {
+        fprintf(aFile, "{\n  \"seed\": %u,\n  \"targeting\": \"%s\",\n  \"target_lists\": \"%s\",\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"unit\": \"ms\",\n  \"cases\": [\n",
+            aSeed, SpatialIndex::GetBackendName(aTargetingBackend), MineManager::GetTargetListModeName(aTargetListMode), aWarmup, aRepetitions);
+
+        for (size_t i = 0; i < aCases.size(); i++)
+        {
+            const BenchmarkCase& benchmarkCase(aCases[i]);
+
+            fprintf(aFile, "    {\"teams\": %d, \"mines_per_team\": %d, \"threads\": %d, \"distribution\": \"%s\", \"radii\": \"%s\", \"turns\": %d, \"phases\": {\n",
+                benchmarkCase.m_numberOfTeams, benchmarkCase.m_numberOfMinesPerTeam, benchmarkCase.m_numberOfThreads,
+                Simulation::GetDistributionName(benchmarkCase.m_distribution), MineManager::GetRadiusDistributionName(benchmarkCase.m_radiusDistribution),
+                benchmarkCase.m_numberOfTurns);
+
+            for (int phase = 0; phase <= cTotalPhase; phase++)
+            {
+                const PhaseStatistics statistics(GetStatistics(benchmarkCase.m_samples[phase]));
+
+                fprintf(aFile, "      \"%s\": {\"min\": %.3f, \"median\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f", GetPhaseName(phase),
+                    statistics.m_min, statistics.m_median, statistics.m_p90, statistics.m_p99, statistics.m_max);
+
+                if (HasCounters(phase))
+                {
+                    fprintf(aFile, ", \"counters\": {");
+
+                    for (int counter = 0; counter < PC_COUNT; counter++)
+                    {
+                        char name[32];
+                        char text[32];
+
+                        fprintf(aFile, "%s\"%s\": %s", 0 < counter ? ", " : "", GetCounterKey(counter, name, sizeof(name)),
+                            FormatCounter(benchmarkCase, phase, counter, "null", text, sizeof(text)));
+                    }
+
+                    fprintf(aFile, "}");
+                }
+
+                fprintf(aFile, "}%s\n", phase < cTotalPhase ? "," : "");
+            }
+
+            fprintf(aFile, "    }}%s\n", i + 1 < aCases.size() ? "," : "");
+        }
+
+        fprintf(aFile, "  ]\n}\n");
+    }
+}
+
+int main(int aArgc, char* aArgv[])
+{
+    std::vector<int> teams(1, 5);
+    std::vector<int> minesPerTeam(1, 1500);
+    std::vector<int> threads(1, 4);
+    std::vector<SpawnDistribution> distributions(1, SD_UNIFORM);
+    std::vector<RadiusDistribution> radiusDistributions(1, RD_UNIFORM);
+    int warmup(1);
+    int repetitions(5);
+    unsigned int seed(654321);
+    TargetingBackend targetingBackend(TB_SPATIAL_GRID);
+    TargetListMode targetListMode(TL_FULL);
+    bool csv(false);
+    const char* outputPath(NULL);
+    bool usePerfCounters(false);
+
+    for (int i = 1; i < aArgc; i++)
+    {
+        const char* value(NULL);
+        bool valid(true);
+
+        if (NULL != (value = GetOptionValue(aArgv[i], "perf-counters")))
+        {
+            valid = 0 == strcmp(value, "on") || 0 == strcmp(value, "off");
+            usePerfCounters = 0 == strcmp(value, "on");
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "teams")))
+        {
+            valid = ParseIntegerList(value, teams);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "mines")))
+        {
+            valid = ParseIntegerList(value, minesPerTeam);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "threads")))
+        {
+            valid = ParseIntegerList(value, threads);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "distribution")))
+        {
+            valid = ParseNameList(value, Simulation::ParseDistribution, distributions);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "radii")))
+        {
+            valid = ParseNameList(value, MineManager::ParseRadiusDistribution, radiusDistributions);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "warmup")))
+        {
+            warmup = atoi(value);
+            valid = warmup >= 0;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "repetitions")))
+        {
+            repetitions = atoi(value);
+            valid = repetitions > 0;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "seed")))
+        {
+            seed = static_cast<unsigned int>(strtoul(value, NULL, 10));
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "targeting")))
+        {
+            valid = SpatialIndex::ParseBackend(value, targetingBackend);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "target-lists")))
+        {
+            valid = MineManager::ParseTargetListMode(value, targetListMode);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "format")))
+        {
+            valid = 0 == strcmp(value, "json") || 0 == strcmp(value, "csv");
+            csv = 0 == strcmp(value, "csv");
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "output")))
+        {
+            outputPath = value;
+        }
+        else
+        {
+            printf("Unknown option '%s'\n", aArgv[i]);
+            return 1;
+        }
+
+        if (!valid)
+        {
+            printf("Invalid value in '%s'\n", aArgv[i]);
+            return 1;
+        }
+    }
+
+    for (const int numberOfMinesPerTeam : minesPerTeam)
+    {
+        for (const int numberOfTeams : teams)
+        {
+            if (static_cast<long long>(numberOfTeams) * numberOfMinesPerTeam > cMaximumNumberOfObjects)
+            {
+                printf("%d teams of %d mines exceed the %d objects limit\n", numberOfTeams, numberOfMinesPerTeam, cMaximumNumberOfObjects);
+                return 1;
+            }
+        }
+    }
+
+    /* Before the sweep, a bad path should not cost a whole run */
+    FILE* output(NULL != outputPath ? fopen(outputPath, "w") : stdout);
+
+    if (NULL == output)
+    {
+        printf("Cannot write '%s'\n", outputPath);
+        return 1;
+    }
+
+    if (!CheckDistanceKernel(seed))
+    {
+        return 1;
+    }
+
+    if (usePerfCounters && !PerfCounters::Enable())
+    {
+        fprintf(stderr, "Performance counters unavailable: %s\n", PerfCounters::GetUnavailableReason());
+    }
+
+    /* Turn reports would be timed along with the phases */
+    Logger::SetLevel(LL_SILENT);
+    MineManager::GetInstance().SetTargetListMode(targetListMode);
+
+    std::vector<BenchmarkCase> cases;
+
+    for (const int numberOfThreads : threads)
+    {
+        WorkerPool workerPool;
+        workerPool.Start(numberOfThreads);
+
+        for (const SpawnDistribution distribution : distributions)
+        {
+            for (const RadiusDistribution radiusDistribution : radiusDistributions)
+            {
+                for (const int numberOfTeams : teams)
+                {
+                    for (const int numberOfMinesPerTeam : minesPerTeam)
+                    {
+                        BenchmarkCase benchmarkCase = {};
+                        double phaseTimes[SP_COUNT + 1];
+
+                        benchmarkCase.m_numberOfTeams = numberOfTeams;
+                        benchmarkCase.m_numberOfMinesPerTeam = numberOfMinesPerTeam;
+                        benchmarkCase.m_numberOfThreads = numberOfThreads;
+                        benchmarkCase.m_distribution = distribution;
+                        benchmarkCase.m_radiusDistribution = radiusDistribution;
+                        benchmarkCase.m_numberOfTurns = 0;
+
+                        fprintf(stderr, "%d teams, %d mines per team, %d threads, %s, %s radii...\n", numberOfTeams, numberOfMinesPerTeam, numberOfThreads,
+                            Simulation::GetDistributionName(distribution), MineManager::GetRadiusDistributionName(radiusDistribution));
+
+                        for (int run = 0; run < warmup + repetitions; run++)
+                        {
+                            PerfCounters::Reset();
+
+                            benchmarkCase.m_numberOfTurns = PlayGame(benchmarkCase, workerPool, seed, targetingBackend, phaseTimes);
+
+                            for (int phase = 0; run >= warmup && phase <= cTotalPhase; phase++)
+                            {
+                                benchmarkCase.m_samples[phase].push_back(phaseTimes[phase]);
+                            }
+                            for (int phase = 0; run >= warmup && phase < SP_COUNT; phase++)
+                            {
+                                const PerfCounterValues values(PerfCounters::GetTotals(static_cast<SimulationPhase>(phase)));
+
+                                for (int counter = 0; counter < PC_COUNT; counter++)
+                                {
+                                    benchmarkCase.m_counters[phase].m_value[counter] += values.m_value[counter];
+                                    benchmarkCase.m_counters[phase].m_available[counter] = values.m_available[counter];
+                                }
+                            }
+                        }
+
+                        cases.push_back(benchmarkCase);
+                    }
+                }
+            }
+        }
+
+        workerPool.Stop();
+    }
+
+    MineManager::GetInstance().Dispose();
+
+    if (csv)
+    {
+        WriteCsv(output, cases, targetingBackend, targetListMode);
+    }
+    else
+    {
+        WriteJson(output, cases, targetingBackend, targetListMode, seed, warmup, repetitions);
+    }
+
+    if (stdout != output)
+    {
+        fclose(output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include "stdafx.h"
+#include "BruteForceIndex.h"
+#include "DistanceKernel.h"
+
+BruteForceIndex::BruteForceIndex(const MineStorage& aStorage) :
+    m_storage(aStorage)
+{
+}
+
+BruteForceIndex::~BruteForceIndex()
+{
+}
+
+void BruteForceIndex::QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const
+{
+    DistanceKernel::AppendInRadius(m_storage.m_positionX.data(), m_storage.m_positionY.data(), m_storage.m_positionZ.data(), NULL,
+                                   m_storage.GetSize(), aCenter, aRadius * aRadius, m_storage.m_bitFlags.data(), aRejectFlags, aOut);
+}
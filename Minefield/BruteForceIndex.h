@@ -0,0 +1,24 @@
+#pragma once
+
+#include "SpatialIndex.h"
+
+/// <summary>
+/// Reference broadphase: streams the storage position arrays and tests every mine on each query.
+/// O(N) per query, only meant as a baseline to benchmark the other backends against.
+/// </summary>
+class BruteForceIndex : public SpatialIndex
+{
+public:
+    BruteForceIndex(const MineStorage& aStorage);
+    ~BruteForceIndex(void);
+
+    /* Overrided functions. Storage is read directly, so there is nothing to keep in sync */
+    virtual void Insert(const int aIndex, const Vector3& aPosition) override {}
+    virtual void Remove(const int aIndex, const Vector3& aPosition) override {}
+    virtual void Relocate(const int aFrom, const int aTo, const Vector3& aPosition) override {}
+    virtual void Clear(void) override {}
+    virtual void QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const override;
+
+private:
+    const MineStorage& m_storage;
+};
@@ -0,0 +1,379 @@
+#include "stdafx.h"
+#include "DistanceKernel.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DISTANCE_KERNEL_X86 1
+#include <immintrin.h>
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+#endif
+
+/* MSVC lets intrinsics be used anywhere, GCC and Clang need the instruction set enabled per function.
+   AVX-512 brings FMA with it, and GCC would fuse the distance sums into it, rounding them differently from
+   Vector3::SqrDistance. Clang and MSVC only contract within a single expression, which intrinsics never are */
+#if defined(_MSC_VER)
+#define KERNEL_TARGET(aInstructionSet)
+#elif defined(__clang__)
+#define KERNEL_TARGET(aInstructionSet) __attribute__((target(aInstructionSet)))
+#else
+#define KERNEL_TARGET(aInstructionSet) __attribute__((target(aInstructionSet), optimize("fp-contract=off")))
+#endif
+
+namespace
+{
+    /* Positions processed per kernel call. Output buffer lives on the stack */
+    const int cChunkSize = 512;
+    /* Vector kernels store whole registers to the output, so it needs room past the last match */
+    const int cOutputSlack = 16;
+    /* Below one AVX2 register worth of positions the vector setup costs more than it saves */
+    const int cMinVectorCount = 8;
+
+    /// <summary>
+    /// Writes matching slots to aOut, returns how many. When aSlots is not NULL flags are not tested,
+    /// AppendInRadius filters them afterwards since they are indexed by slot.
+    /// </summary>
+    typedef int (*FilterFunction)(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                                  const Vector3& aCenter, const float aSqrRadius,
+                                  const unsigned char* aFlags, const unsigned char aRejectFlags, int* aOut);
+
+    /* Summation order matches Vector3::SqrDistance, so every level reports exactly the same matches */
+    int FilterScalar(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                     const Vector3& aCenter, const float aSqrRadius,
+                     const unsigned char* aFlags, const unsigned char aRejectFlags, int* aOut)
+    {
+        const bool testFlags(NULL != aFlags && NULL == aSlots);
+        int numberOfMatches(0);
+
+        for (int i = 0; i < aCount; ++i)
+        {
+            const float dx(aX[i] - aCenter.x);
+            const float dy(aY[i] - aCenter.y);
+            const float dz(aZ[i] - aCenter.z);
+
+            if (dx * dx + dy * dy + dz * dz <= aSqrRadius && !(testFlags && (aFlags[i] & aRejectFlags)))
+            {
+                aOut[numberOfMatches++] = NULL != aSlots ? aSlots[i] : i;
+            }
+        }
+
+        return numberOfMatches;
+    }
+
+#if DISTANCE_KERNEL_X86
+    /// <summary>
+    /// Lane permutation moving the set lanes of an 8 bit mask to the front, plus number of set lanes.
+    /// </summary>
+    struct CompressTable
+    {
+        CompressTable(void)
+        {
+            for (int mask = 0; mask < 256; ++mask)
+            {
+                m_count[mask] = 0;
+
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    m_lanes[mask][lane] = 0;
+                }
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        m_lanes[mask][m_count[mask]++] = lane;
+                    }
+                }
+            }
+        }
+
+        int m_lanes[256][8];
+        int m_count[256];
+    };
+
+    const CompressTable s_compressTable;
+
+    inline int PopCount16(const unsigned int aMask)
+    {
+        return s_compressTable.m_count[aMask & 0xFF] + s_compressTable.m_count[(aMask >> 8) & 0xFF];
+    }
+
+    KERNEL_TARGET("avx2")
+    int FilterAvx2(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                   const Vector3& aCenter, const float aSqrRadius,
+                   const unsigned char* aFlags, const unsigned char aRejectFlags, int* aOut)
+    {
+        const bool testFlags(NULL != aFlags && NULL == aSlots);
+        const __m256 centerX(_mm256_set1_ps(aCenter.x));
+        const __m256 centerY(_mm256_set1_ps(aCenter.y));
+        const __m256 centerZ(_mm256_set1_ps(aCenter.z));
+        const __m256 sqrRadius(_mm256_set1_ps(aSqrRadius));
+        const __m256i rejectFlags(_mm256_set1_epi32(aRejectFlags));
+        const __m256i laneOffsets(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+        int numberOfMatches(0);
+        int i(0);
+
+        for (; i + 8 <= aCount; i += 8)
+        {
+            const __m256 dx(_mm256_sub_ps(_mm256_loadu_ps(aX + i), centerX));
+            const __m256 dy(_mm256_sub_ps(_mm256_loadu_ps(aY + i), centerY));
+            const __m256 dz(_mm256_sub_ps(_mm256_loadu_ps(aZ + i), centerZ));
+            const __m256 sqrDistance(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+
+            int mask(_mm256_movemask_ps(_mm256_cmp_ps(sqrDistance, sqrRadius, _CMP_LE_OQ)));
+
+            if (0 != mask && testFlags)
+            {
+                const __m256i flags(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aFlags + i))));
+                const __m256i accepted(_mm256_cmpeq_epi32(_mm256_and_si256(flags, rejectFlags), _mm256_setzero_si256()));
+
+                mask &= _mm256_movemask_ps(_mm256_castsi256_ps(accepted));
+            }
+
+            if (0 != mask)
+            {
+                const __m256i slots(NULL != aSlots ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSlots + i)) : _mm256_add_epi32(_mm256_set1_epi32(i), laneOffsets));
+                const __m256i lanes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s_compressTable.m_lanes[mask])));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut + numberOfMatches), _mm256_permutevar8x32_epi32(slots, lanes));
+                numberOfMatches += s_compressTable.m_count[mask];
+            }
+        }
+
+        /* Fewer than 8 positions left */
+        const int tailMatches(FilterScalar(aX + i, aY + i, aZ + i, NULL != aSlots ? aSlots + i : NULL, aCount - i, aCenter, aSqrRadius,
+                                           NULL != aFlags ? aFlags + i : NULL, aRejectFlags, aOut + numberOfMatches));
+
+        if (NULL == aSlots)
+        {
+            for (int j = numberOfMatches; j < numberOfMatches + tailMatches; ++j)
+            {
+                aOut[j] += i;
+            }
+        }
+
+        return numberOfMatches + tailMatches;
+    }
+
+    KERNEL_TARGET("avx512f")
+    int FilterAvx512(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                     const Vector3& aCenter, const float aSqrRadius,
+                     const unsigned char* aFlags, const unsigned char aRejectFlags, int* aOut)
+    {
+        const bool testFlags(NULL != aFlags && NULL == aSlots);
+        const __m512 centerX(_mm512_set1_ps(aCenter.x));
+        const __m512 centerY(_mm512_set1_ps(aCenter.y));
+        const __m512 centerZ(_mm512_set1_ps(aCenter.z));
+        const __m512 sqrRadius(_mm512_set1_ps(aSqrRadius));
+        const __m512i rejectFlags(_mm512_set1_epi32(aRejectFlags));
+        const __m512i laneOffsets(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+        int numberOfMatches(0);
+
+        for (int i = 0; i < aCount; i += 16)
+        {
+            /* Masked loads do not touch memory of disabled lanes, so the tail needs no scalar loop */
+            const int remaining(aCount - i);
+            const __mmask16 active(remaining >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << remaining) - 1));
+
+            const __m512 dx(_mm512_sub_ps(_mm512_maskz_loadu_ps(active, aX + i), centerX));
+            const __m512 dy(_mm512_sub_ps(_mm512_maskz_loadu_ps(active, aY + i), centerY));
+            const __m512 dz(_mm512_sub_ps(_mm512_maskz_loadu_ps(active, aZ + i), centerZ));
+            const __m512 sqrDistance(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz)));
+
+            __mmask16 mask(_mm512_mask_cmp_ps_mask(active, sqrDistance, sqrRadius, _CMP_LE_OQ));
+
+            if (0 != mask && testFlags)
+            {
+                if (remaining >= 16)
+                {
+                    /* Zero masked widening: the plain one starts from an undefined register */
+                    const __m512i flags(_mm512_maskz_cvtepu8_epi32(mask, _mm_loadu_si128(reinterpret_cast<const __m128i*>(aFlags + i))));
+
+                    mask = _mm512_mask_testn_epi32_mask(mask, flags, rejectFlags);
+                }
+                else
+                {
+                    /* Byte masked loads need AVX-512BW, tail flags are tested one by one */
+                    for (int lane = 0; lane < remaining; ++lane)
+                    {
+                        if (aFlags[i + lane] & aRejectFlags)
+                        {
+                            mask = static_cast<__mmask16>(mask & ~(1u << lane));
+                        }
+                    }
+                }
+            }
+
+            if (0 != mask)
+            {
+                const __m512i slots(NULL != aSlots ? _mm512_maskz_loadu_epi32(active, aSlots + i) : _mm512_add_epi32(_mm512_set1_epi32(i), laneOffsets));
+
+                _mm512_mask_compressstoreu_epi32(aOut + numberOfMatches, mask, slots);
+                numberOfMatches += PopCount16(mask);
+            }
+        }
+
+        return numberOfMatches;
+    }
+#endif
+
+    FilterFunction GetFilterFunction(const SimdLevel aLevel)
+    {
+#if DISTANCE_KERNEL_X86
+        switch (aLevel)
+        {
+        case SL_AVX512:
+            return FilterAvx512;
+        case SL_AVX2:
+            return FilterAvx2;
+        default:
+            break;
+        }
+#endif
+        return FilterScalar;
+    }
+
+    SimdLevel      s_level(DistanceKernel::GetSupportedLevel());
+    FilterFunction s_pFilter(GetFilterFunction(s_level));
+}
+
+SimdLevel DistanceKernel::GetSupportedLevel(void)
+{
+    SimdLevel out_level = SL_SCALAR;
+
+#if DISTANCE_KERNEL_X86
+#ifdef _WIN32
+    int info[4] = { 0 };
+
+    __cpuid(info, 0);
+    const int maxLeaf(info[0]);
+
+    __cpuid(info, 1);
+
+    /* OS must save the wide registers on context switch (OSXSAVE + XCR0) */
+    if (maxLeaf >= 7 && (info[2] & (1 << 27)))
+    {
+        const unsigned long long enabledStates(_xgetbv(0));
+
+        __cpuidex(info, 7, 0);
+
+        if ((enabledStates & 0x6) == 0x6 && (info[1] & (1 << 5)))
+        {
+            out_level = SL_AVX2;
+        }
+        if ((enabledStates & 0xE6) == 0xE6 && (info[1] & (1 << 16)))
+        {
+            out_level = SL_AVX512;
+        }
+    }
+#else
+    /* Also checks the OS enabled the wide register state */
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        out_level = SL_AVX512;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        out_level = SL_AVX2;
+    }
+#endif
+#endif
+
+    return out_level;
+}
+
+SimdLevel DistanceKernel::GetLevel(void)
+{
+    return s_level;
+}
+
+bool DistanceKernel::SetLevel(const SimdLevel aLevel)
+{
+    if (aLevel > GetSupportedLevel())
+    {
+        return false;
+    }
+
+    s_level = aLevel;
+    s_pFilter = GetFilterFunction(aLevel);
+
+    return true;
+}
+
+const char* DistanceKernel::GetLevelName(const SimdLevel aLevel)
+{
+    switch (aLevel)
+    {
+    case SL_SCALAR:
+        return "scalar";
+    case SL_AVX2:
+        return "avx2";
+    case SL_AVX512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
+
+bool DistanceKernel::ParseLevel(const char* aName, SimdLevel& aOutLevel)
+{
+    const SimdLevel levels[] = { SL_SCALAR, SL_AVX2, SL_AVX512 };
+
+    for (const SimdLevel level : levels)
+    {
+        if (NULL != aName && 0 == strcmp(aName, GetLevelName(level)))
+        {
+            aOutLevel = level;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DistanceKernel::AppendInRadius(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                                    const Vector3& aCenter, const float aSqrRadius,
+                                    const unsigned char* aFlags, const unsigned char aRejectFlags, std::vector<int>& aOut)
+{
+    int matches[cChunkSize + cOutputSlack];
+
+    /* Sparse grid cells and k-d leaves are often nearly empty */
+    const FilterFunction pFilter(aCount < cMinVectorCount ? FilterScalar : s_pFilter);
+
+    for (int begin = 0; begin < aCount; begin += cChunkSize)
+    {
+        const int count(aCount - begin < cChunkSize ? aCount - begin : cChunkSize);
+
+        int numberOfMatches(pFilter(aX + begin, aY + begin, aZ + begin, NULL != aSlots ? aSlots + begin : NULL, count,
+                                    aCenter, aSqrRadius, NULL != aFlags && NULL == aSlots ? aFlags + begin : NULL, aRejectFlags, matches));
+
+        if (NULL == aSlots)
+        {
+            /* Kernel reports chunk relative positions, which are the slots themselves */
+            for (int i = 0; i < numberOfMatches; ++i)
+            {
+                matches[i] += begin;
+            }
+        }
+        else if (NULL != aFlags)
+        {
+            /* Flags are indexed by slot, not by position; only the few matches need checking */
+            int accepted(0);
+
+            for (int i = 0; i < numberOfMatches; ++i)
+            {
+                if (!(aFlags[matches[i]] & aRejectFlags))
+                {
+                    matches[accepted++] = matches[i];
+                }
+            }
+
+            numberOfMatches = accepted;
+        }
+
+        aOut.insert(aOut.end(), matches, matches + numberOfMatches);
+    }
+}
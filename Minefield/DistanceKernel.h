@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Object.h"
+#include <vector>
+
+/// <summary>
+/// Instruction sets the distance kernel can run on.
+/// </summary>
+enum SimdLevel
+{
+    SL_SCALAR = 0,
+    SL_AVX2,
+    SL_AVX512
+};
+
+/// <summary>
+/// Vectorized radius test shared by every targeting backend. Tests 8 (AVX2) or 16 (AVX-512) positions
+/// at once against a squared radius and a flag mask and writes the slot index of every match to a
+/// compacted output list. The widest instruction set the CPU supports is picked at startup, with a
+/// scalar fallback, so the same binary runs everywhere.
+/// </summary>
+class DistanceKernel
+{
+public:
+    /// <summary>
+    /// Returns widest instruction set supported by this CPU (and OS).
+    /// </summary>
+    /// <returns>SimdLevel. Best available level</returns>
+    static SimdLevel GetSupportedLevel(void);
+    /// <summary>
+    /// Returns instruction set currently in use.
+    /// </summary>
+    /// <returns>SimdLevel. Active level</returns>
+    static SimdLevel GetLevel(void);
+    /// <summary>
+    /// Forces an instruction set, e.g. to compare against the scalar path. Not thread safe, call before
+    /// the workers start.
+    /// </summary>
+    /// <param name="aLevel">SimdLevel. Level to use</param>
+    /// <returns>bool. False if the CPU does not support it, active level is left untouched</returns>
+    static bool SetLevel(const SimdLevel aLevel);
+    /// <summary>
+    /// Returns printable level name.
+    /// </summary>
+    /// <param name="aLevel">SimdLevel. Level</param>
+    /// <returns>const char*. Name, as accepted by ParseLevel</returns>
+    static const char* GetLevelName(const SimdLevel aLevel);
+    /// <summary>
+    /// Parses level name (scalar, avx2, avx512).
+    /// </summary>
+    /// <param name="aName">const char*. Name to parse</param>
+    /// <param name="aOutLevel">SimdLevel&. Parsed level</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseLevel(const char* aName, SimdLevel& aOutLevel);
+
+    /// <summary>
+    /// Appends to aOut the slot of every position within sqrt(aSqrRadius) of aCenter whose flags share
+    /// no bit with aRejectFlags.
+    /// </summary>
+    /// <param name="aX">const float*. Contiguous x coordinates</param>
+    /// <param name="aY">const float*. Contiguous y coordinates</param>
+    /// <param name="aZ">const float*. Contiguous z coordinates</param>
+    /// <param name="aSlots">const int*. Slot index of every position, NULL when position i is slot i</param>
+    /// <param name="aCount">int. Number of positions</param>
+    /// <param name="aCenter">Vector3. Query center</param>
+    /// <param name="aSqrRadius">float. Squared query radius</param>
+    /// <param name="aFlags">const unsigned char*. Flags indexed by slot, NULL to skip the flag test</param>
+    /// <param name="aRejectFlags">unsigned char. Slots having any of these flags are not reported</param>
+    /// <param name="aOut">std::vector<int>&. Output list, not cleared</param>
+    static void AppendInRadius(const float* aX, const float* aY, const float* aZ, const int* aSlots, const int aCount,
+                               const Vector3& aCenter, const float aSqrRadius,
+                               const unsigned char* aFlags, const unsigned char aRejectFlags, std::vector<int>& aOut);
+};
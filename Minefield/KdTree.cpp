@@ -0,0 +1,293 @@
+#include "stdafx.h"
+#include "KdTree.h"
+#include "DistanceKernel.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    /* Leaves are scanned linearly, a few entries per leaf keeps the tree shallow */
+    const int cLeafSize = 8;
+    /* Node traversal stack. Median splits keep depth at log2(N / cLeafSize) */
+    const int cMaxTreeDepth = 64;
+
+    inline float AxisValue(const Vector3& aVector, const int aAxis)
+    {
+        return 0 == aAxis ? aVector.x : (1 == aAxis ? aVector.y : aVector.z);
+    }
+
+    /* Squared distance from point to box, zero if inside */
+    inline float SqrDistanceToBox(const Vector3& aPoint, const Vector3& aMin, const Vector3& aMax)
+    {
+        const float dx(std::max(std::max(aMin.x - aPoint.x, aPoint.x - aMax.x), 0.0f));
+        const float dy(std::max(std::max(aMin.y - aPoint.y, aPoint.y - aMax.y), 0.0f));
+        const float dz(std::max(std::max(aMin.z - aPoint.z, aPoint.z - aMax.z), 0.0f));
+
+        return dx * dx + dy * dy + dz * dz;
+    }
+}
+
+KdTree::KdTree(const MineStorage& aStorage) :
+    m_storage(aStorage)
+  , m_numberOfDeadEntries(0)
+  , m_needsRebuild(false)
+  , m_needsRefit(false)
+{
+}
+
+KdTree::~KdTree()
+{
+}
+
+void KdTree::Insert(const int aIndex, const Vector3& aPosition)
+{
+    if (aIndex >= static_cast<int>(m_entryOfSlot.size()))
+    {
+        m_entryOfSlot.resize(aIndex + 1, -1);
+    }
+
+    m_entryOfSlot[aIndex] = static_cast<int>(m_entries.size());
+    m_entries.push_back({ aPosition, aIndex });
+    m_alive.push_back(1);
+    m_needsRebuild = true;
+}
+
+void KdTree::Remove(const int aIndex, const Vector3& aPosition)
+{
+    if (aIndex < static_cast<int>(m_entryOfSlot.size()) && m_entryOfSlot[aIndex] >= 0)
+    {
+        /* Tombstone only, entries keep their tree position until next rebuild */
+        const int entry(m_entryOfSlot[aIndex]);
+
+        m_alive[entry] = 0;
+
+        /* Entries inserted since last rebuild are not in the leaf arrays yet */
+        if (entry < static_cast<int>(m_leafPositionX.size()))
+        {
+            m_leafPositionX[entry] = std::numeric_limits<float>::infinity();
+        }
+
+        m_entryOfSlot[aIndex] = -1;
+        m_numberOfDeadEntries++;
+        m_needsRefit = true;
+    }
+}
+
+void KdTree::Relocate(const int aFrom, const int aTo, const Vector3& aPosition)
+{
+    if (aFrom < static_cast<int>(m_entryOfSlot.size()) && m_entryOfSlot[aFrom] >= 0 && aTo < static_cast<int>(m_entryOfSlot.size()))
+    {
+        const int entry(m_entryOfSlot[aFrom]);
+
+        m_entryOfSlot[aFrom] = -1;
+        m_entries[entry].m_index = aTo;
+        m_entryOfSlot[aTo] = entry;
+
+        if (entry < static_cast<int>(m_leafIndex.size()))
+        {
+            m_leafIndex[entry] = aTo;
+        }
+    }
+}
+
+void KdTree::Clear(void)
+{
+    m_entries.clear();
+    m_alive.clear();
+    m_nodes.clear();
+    m_leafPositionX.clear();
+    m_leafPositionY.clear();
+    m_leafPositionZ.clear();
+    m_leafIndex.clear();
+    m_entryOfSlot.clear();
+    m_numberOfDeadEntries = 0;
+    m_needsRebuild = false;
+    m_needsRefit = false;
+}
+
+void KdTree::Refresh(void)
+{
+    if (m_needsRebuild || m_numberOfDeadEntries * 2 > static_cast<int>(m_entries.size()))
+    {
+        Rebuild();
+    }
+    else if (m_needsRefit)
+    {
+        Refit();
+    }
+}
+
+void KdTree::Rebuild(void)
+{
+    if (m_numberOfDeadEntries > 0)
+    {
+        int alive(0);
+
+        for (int i = 0; i < static_cast<int>(m_entries.size()); ++i)
+        {
+            if (m_alive[i])
+            {
+                m_entries[alive++] = m_entries[i];
+            }
+        }
+
+        m_entries.resize(alive);
+        m_alive.assign(alive, 1);
+        m_numberOfDeadEntries = 0;
+    }
+
+    m_nodes.clear();
+
+    if (!m_entries.empty())
+    {
+        m_nodes.reserve(2 * (m_entries.size() / cLeafSize + 1));
+        BuildNode(0, static_cast<int>(m_entries.size()));
+    }
+
+    /* Median splits reordered entries */
+    const int numberOfEntries(static_cast<int>(m_entries.size()));
+
+    m_leafPositionX.resize(numberOfEntries);
+    m_leafPositionY.resize(numberOfEntries);
+    m_leafPositionZ.resize(numberOfEntries);
+    m_leafIndex.resize(numberOfEntries);
+
+    for (int i = 0; i < numberOfEntries; ++i)
+    {
+        const Entry& entry(m_entries[i]);
+
+        m_entryOfSlot[entry.m_index] = i;
+        m_leafPositionX[i] = entry.m_position.x;
+        m_leafPositionY[i] = entry.m_position.y;
+        m_leafPositionZ[i] = entry.m_position.z;
+        m_leafIndex[i] = entry.m_index;
+    }
+
+    m_needsRebuild = false;
+    m_needsRefit = false;
+}
+
+int KdTree::BuildNode(const int aBegin, const int aEnd)
+{
+    const int nodeIndex(static_cast<int>(m_nodes.size()));
+
+    Node node;
+    node.m_min = m_entries[aBegin].m_position;
+    node.m_max = m_entries[aBegin].m_position;
+    node.m_begin = aBegin;
+    node.m_end = aEnd;
+    node.m_left = -1;
+    node.m_right = -1;
+
+    for (int i = aBegin + 1; i < aEnd; ++i)
+    {
+        const Vector3& position(m_entries[i].m_position);
+
+        node.m_min = Vector3(std::min(node.m_min.x, position.x), std::min(node.m_min.y, position.y), std::min(node.m_min.z, position.z));
+        node.m_max = Vector3(std::max(node.m_max.x, position.x), std::max(node.m_max.y, position.y), std::max(node.m_max.z, position.z));
+    }
+
+    m_nodes.push_back(node);
+
+    if (aEnd - aBegin > cLeafSize)
+    {
+        /* Split at the median of the widest axis */
+        const Vector3 extent(node.m_max - node.m_min);
+        const int axis(extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2));
+        const int middle(aBegin + (aEnd - aBegin) / 2);
+
+        std::nth_element(m_entries.begin() + aBegin, m_entries.begin() + middle, m_entries.begin() + aEnd, [axis](const Entry& aLeft, const Entry& aRight) {
+                return AxisValue(aLeft.m_position, axis) < AxisValue(aRight.m_position, axis);
+            });
+
+        /* m_nodes may grow while building children, so no reference is held across calls */
+        const int left(BuildNode(aBegin, middle));
+        const int right(BuildNode(middle, aEnd));
+
+        m_nodes[nodeIndex].m_left = left;
+        m_nodes[nodeIndex].m_right = right;
+    }
+
+    return nodeIndex;
+}
+
+void KdTree::Refit(void)
+{
+    const float maxValue(std::numeric_limits<float>::max());
+
+    /* Children are always stored after their parent, so a reverse walk visits them first */
+    for (int i = static_cast<int>(m_nodes.size()) - 1; i >= 0; --i)
+    {
+        Node& node(m_nodes[i]);
+
+        /* Inverted box for nodes with nothing alive below, no query can reach it */
+        Vector3 boxMin(maxValue, maxValue, maxValue);
+        Vector3 boxMax(-maxValue, -maxValue, -maxValue);
+
+        if (node.m_left < 0)
+        {
+            for (int j = node.m_begin; j < node.m_end; ++j)
+            {
+                if (m_alive[j])
+                {
+                    const Vector3& position(m_entries[j].m_position);
+
+                    boxMin = Vector3(std::min(boxMin.x, position.x), std::min(boxMin.y, position.y), std::min(boxMin.z, position.z));
+                    boxMax = Vector3(std::max(boxMax.x, position.x), std::max(boxMax.y, position.y), std::max(boxMax.z, position.z));
+                }
+            }
+        }
+        else
+        {
+            const Node& left(m_nodes[node.m_left]);
+            const Node& right(m_nodes[node.m_right]);
+
+            boxMin = Vector3(std::min(left.m_min.x, right.m_min.x), std::min(left.m_min.y, right.m_min.y), std::min(left.m_min.z, right.m_min.z));
+            boxMax = Vector3(std::max(left.m_max.x, right.m_max.x), std::max(left.m_max.y, right.m_max.y), std::max(left.m_max.z, right.m_max.z));
+        }
+
+        node.m_min = boxMin;
+        node.m_max = boxMax;
+    }
+
+    m_needsRefit = false;
+}
+
+void KdTree::QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const
+{
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    const float sqrRadius(aRadius * aRadius);
+    const unsigned char* flags(m_storage.m_bitFlags.data());
+
+    int stack[cMaxTreeDepth];
+    int stackSize(0);
+
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node(m_nodes[stack[--stackSize]]);
+
+        if (SqrDistanceToBox(aCenter, node.m_min, node.m_max) > sqrRadius)
+        {
+            continue;
+        }
+
+        if (node.m_left < 0)
+        {
+            const int begin(node.m_begin);
+
+            DistanceKernel::AppendInRadius(&m_leafPositionX[begin], &m_leafPositionY[begin], &m_leafPositionZ[begin], &m_leafIndex[begin],
+                                           node.m_end - begin, aCenter, sqrRadius, flags, aRejectFlags, aOut);
+        }
+        else
+        {
+            stack[stackSize++] = node.m_right;
+            stack[stackSize++] = node.m_left;
+        }
+    }
+}
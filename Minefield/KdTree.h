@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SpatialIndex.h"
+#include <vector>
+
+/// <summary>
+/// Bounding-box k-d tree broadphase. Entries are split at the median of their widest axis until
+/// leaves hold a handful of mines, and every node keeps the bounds of what lies below it, so a query
+/// prunes whole subtrees the sphere does not reach. Adapts to clustered and sparse fields alike,
+/// unlike a uniform grid whose cell size is fixed.
+/// Insertions take effect on next Refresh (full rebuild). Removals are tombstoned and bounds are
+/// refit on next Refresh; the tree is rebuilt once half of its entries are dead.
+/// </summary>
+class KdTree : public SpatialIndex
+{
+public:
+    KdTree(const MineStorage& aStorage);
+    ~KdTree(void);
+
+    /* Overrided functions */
+    virtual void Insert(const int aIndex, const Vector3& aPosition) override;
+    virtual void Remove(const int aIndex, const Vector3& aPosition) override;
+    virtual void Relocate(const int aFrom, const int aTo, const Vector3& aPosition) override;
+    virtual void Clear(void) override;
+    virtual void Refresh(void) override;
+    virtual void QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const override;
+
+private:
+    struct Entry
+    {
+        Vector3 m_position;
+        int     m_index;
+    };
+
+    struct Node
+    {
+        Vector3 m_min;
+        Vector3 m_max;
+        int m_begin;
+        int m_end;
+        /* Children indexes, -1 for leaves. Right child is always stored after left subtree */
+        int m_left;
+        int m_right;
+    };
+
+    /// <summary>
+    /// Drops dead entries and builds the whole tree again.
+    /// </summary>
+    void Rebuild(void);
+    /// <summary>
+    /// Recursively builds subtree over entries [aBegin, aEnd).
+    /// </summary>
+    /// <returns>int. Index of the created node</returns>
+    int  BuildNode(const int aBegin, const int aEnd);
+    /// <summary>
+    /// Shrinks node bounds to the entries still alive, bottom-up.
+    /// </summary>
+    void Refit(void);
+
+    const MineStorage& m_storage;
+    std::vector<Entry> m_entries;
+    std::vector<unsigned char> m_alive;
+    /* Entries in tree order as parallel arrays, streamed by the distance kernel on leaf visits.
+    Dead entries get an infinite x so they never pass the radius test */
+    std::vector<float> m_leafPositionX;
+    std::vector<float> m_leafPositionY;
+    std::vector<float> m_leafPositionZ;
+    std::vector<int>   m_leafIndex;
+    std::vector<Node> m_nodes;
+    /* Entry position of every storage slot, -1 if not registered */
+    std::vector<int> m_entryOfSlot;
+    int  m_numberOfDeadEntries;
+    bool m_needsRebuild;
+    bool m_needsRefit;
+};
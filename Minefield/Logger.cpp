@@ -0,0 +1,199 @@
+#include "stdafx.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+std::atomic<int> Logger::s_level(LL_MINE);
+
+namespace
+{
+    /* Per thread buffer size. Writer is woken once a buffer is half full */
+    const size_t cRingBufferSize = 1 << 16;
+    /* Writer also wakes up on its own this often, messages never wait longer than that */
+    const std::chrono::milliseconds cWriterPeriod(5);
+
+    /// <summary>
+    /// Single producer (owning thread), single consumer (writer) byte queue. Positions only grow, the
+    /// buffer offset is position modulo size.
+    /// </summary>
+    struct RingBuffer
+    {
+        RingBuffer() : m_head(0), m_tail(0) {}
+
+        char m_data[cRingBufferSize];
+        /* Written by producer */
+        std::atomic<size_t> m_head;
+        /* Written by writer */
+        std::atomic<size_t> m_tail;
+    };
+
+    const char* const cLevelNames[] = { "silent", "summary", "turn", "mine" };
+
+    std::mutex s_lock;
+    std::condition_variable s_wake;
+    std::thread s_writer;
+    std::atomic<bool> s_running(false);
+    bool s_stopping(false);
+    /* Never released: threads keep a pointer to theirs for their whole life */
+    std::vector<std::unique_ptr<RingBuffer>> s_buffers;
+    thread_local RingBuffer* s_pThreadBuffer(NULL);
+
+    RingBuffer& GetThreadBuffer(void)
+    {
+        if (NULL == s_pThreadBuffer)
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+
+            s_buffers.emplace_back(new RingBuffer());
+            s_pThreadBuffer = s_buffers.back().get();
+        }
+
+        return *s_pThreadBuffer;
+    }
+
+    /// <summary>
+    /// Writes out everything queued in a buffer. Writer side only.
+    /// </summary>
+    /// <returns>size_t. Bytes written</returns>
+    size_t Drain(RingBuffer& aBuffer)
+    {
+        const size_t tail(aBuffer.m_tail.load(std::memory_order_relaxed));
+        const size_t head(aBuffer.m_head.load(std::memory_order_acquire));
+        const size_t offset(tail % cRingBufferSize);
+        const size_t size(head - tail);
+        const size_t firstPart(std::min(size, cRingBufferSize - offset));
+
+        fwrite(aBuffer.m_data + offset, 1, firstPart, stdout);
+        fwrite(aBuffer.m_data, 1, size - firstPart, stdout);
+
+        aBuffer.m_tail.store(head, std::memory_order_release);
+
+        return size;
+    }
+
+    void WriterLoop(void)
+    {
+        std::unique_lock<std::mutex> lock(s_lock);
+
+        for (;;)
+        {
+            /* Read before draining: once stopping, producers are done and one more pass empties everything */
+            const bool stopping(s_stopping);
+            size_t written(0);
+
+            for (const std::unique_ptr<RingBuffer>& buffer : s_buffers)
+            {
+                written += Drain(*buffer);
+            }
+
+            if (stopping)
+            {
+                break;
+            }
+            if (0 == written)
+            {
+                s_wake.wait_for(lock, cWriterPeriod);
+            }
+        }
+
+        fflush(stdout);
+    }
+}
+
+void Logger::Start(void)
+{
+    if (!s_running.load())
+    {
+        s_stopping = false;
+        s_writer = std::thread(WriterLoop);
+        s_running.store(true);
+    }
+}
+
+void Logger::Stop(void)
+{
+    if (s_running.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+            s_stopping = true;
+        }
+
+        s_wake.notify_one();
+        s_writer.join();
+        s_running.store(false);
+    }
+}
+
+const char* Logger::GetLevelName(const LogLevel aLevel)
+{
+    return aLevel >= LL_SILENT && aLevel <= LL_MINE ? cLevelNames[aLevel] : "unknown";
+}
+
+bool Logger::ParseLevel(const char* aName, LogLevel& aOutLevel)
+{
+    for (int level = LL_SILENT; level <= LL_MINE; ++level)
+    {
+        if (0 == strcmp(aName, cLevelNames[level]))
+        {
+            aOutLevel = static_cast<LogLevel>(level);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Logger::Write(const char* aFormat, ...)
+{
+    char message[cMaxMessageLength];
+
+    va_list arguments;
+    va_start(arguments, aFormat);
+    const int formatted(vsnprintf(message, sizeof(message), aFormat, arguments));
+    va_end(arguments);
+
+    if (formatted <= 0)
+    {
+        return;
+    }
+
+    const size_t length(std::min(static_cast<size_t>(formatted), sizeof(message) - 1));
+
+    if (!s_running.load(std::memory_order_acquire))
+    {
+        fwrite(message, 1, length, stdout);
+        return;
+    }
+
+    RingBuffer& buffer(GetThreadBuffer());
+    const size_t head(buffer.m_head.load(std::memory_order_relaxed));
+
+    /* Full: hand the writer the CPU until it makes room. Messages are never dropped */
+    while (cRingBufferSize - (head - buffer.m_tail.load(std::memory_order_acquire)) < length)
+    {
+        s_wake.notify_one();
+        std::this_thread::yield();
+    }
+
+    const size_t offset(head % cRingBufferSize);
+    const size_t firstPart(std::min(length, cRingBufferSize - offset));
+
+    memcpy(buffer.m_data + offset, message, firstPart);
+    memcpy(buffer.m_data, message + firstPart, length - firstPart);
+
+    buffer.m_head.store(head + length, std::memory_order_release);
+
+    if (head % (cRingBufferSize / 2) + length >= cRingBufferSize / 2)
+    {
+        s_wake.notify_one();
+    }
+}
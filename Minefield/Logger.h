@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+
+/// <summary>
+/// How much the program reports. Every level includes the ones before it.
+/// </summary>
+enum LogLevel
+{
+    LL_SILENT = 0,
+    /* Configuration and final results */
+    LL_SUMMARY,
+    /* Plus one line per exploding mine picked every turn */
+    LL_TURN,
+    /* Plus one line per spawned mine */
+    LL_MINE
+};
+
+/* Arguments are only evaluated when aLevel is enabled, a disabled message costs a single load and compare */
+#define LOG_MESSAGE(aLevel, ...) do { if (Logger::IsEnabled(aLevel)) { Logger::Write(__VA_ARGS__); } } while (0)
+
+/// <summary>
+/// Asynchronous logger. Messages are formatted by the calling thread into a ring buffer of its own and
+/// written to stdout by a background writer thread, so threads never contend on a lock or wait for the
+/// terminal. Messages of one thread keep their order; messages of different threads may interleave at
+/// line granularity. Before Start and after Stop messages are written right away.
+/// </summary>
+class Logger
+{
+public:
+    /// <summary>
+    /// Starts the writer thread.
+    /// </summary>
+    static void Start(void);
+    /// <summary>
+    /// Writes every pending message and stops the writer thread. Call once other threads stopped logging.
+    /// </summary>
+    static void Stop(void);
+    /// <summary>
+    /// Sets most detailed level reported. LL_MINE by default.
+    /// </summary>
+    /// <param name="aLevel">LogLevel. Level</param>
+    static void SetLevel(const LogLevel aLevel) { s_level.store(aLevel, std::memory_order_relaxed); }
+    /// <summary>
+    /// Returns most detailed level reported.
+    /// </summary>
+    /// <returns>LogLevel. Level</returns>
+    static LogLevel GetLevel(void) { return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed)); }
+    /// <summary>
+    /// Whether messages of a level are reported.
+    /// </summary>
+    /// <param name="aLevel">LogLevel. Message level</param>
+    /// <returns>bool. True if reported</returns>
+    static bool IsEnabled(const LogLevel aLevel) { return aLevel <= s_level.load(std::memory_order_relaxed) && LL_SILENT != aLevel; }
+    /// <summary>
+    /// Returns printable level name.
+    /// </summary>
+    /// <param name="aLevel">LogLevel. Level</param>
+    /// <returns>const char*. Name, as accepted by ParseLevel</returns>
+    static const char* GetLevelName(const LogLevel aLevel);
+    /// <summary>
+    /// Parses level name (silent, summary, turn, mine).
+    /// </summary>
+    /// <param name="aName">const char*. Name to parse</param>
+    /// <param name="aOutLevel">LogLevel&. Parsed level</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseLevel(const char* aName, LogLevel& aOutLevel);
+    /// <summary>
+    /// Formats a message, printf style, and queues it. Level is not checked, use LOG_MESSAGE. Messages
+    /// longer than cMaxMessageLength are truncated.
+    /// </summary>
+    /// <param name="aFormat">const char*. printf format</param>
+    static void Write(const char* aFormat, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 1, 2)))
+#endif
+        ;
+
+    static const int cMaxMessageLength = 1024;
+
+private:
+    static std::atomic<int> s_level;
+};
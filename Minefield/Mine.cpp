@@ -6,12 +6,10 @@
 #include "Mine.h"
 #include "MineManager.h"
 
-Mine::Mine(const int aMineID, const int aPoolID) : 
-    m_destructiveRadius(0.0f)
-  , m_health(100.0f)
-  , m_explosiveYield(500)
-  , m_bitFlags(0)
-  , Object(aMineID, aPoolID) 
+Mine::Mine(MineManager* apManager, MineStorage* apStorage, const int aIndex) :
+    m_pManager(apManager)
+  , m_pStorage(apStorage)
+  , m_index(aIndex)
 {
 }
 
@@ -20,76 +18,132 @@ Mine::~Mine()
 }
 
 // Invulnerable mines do not take damage, but can be manually exploded if they are active
-void Mine::FindCurrentTargets()
+void Mine::FindCurrentTargets(const int aThreadIndex)
 {
-    if (IsActive())
+    /* Ghosts never explode here, their owner targets for them */
+    if (IsActive() && !IsGhost())
     {
-        m_targetList.clear();
+        const unsigned int turn(m_pManager->GetTargetingPass());
+        bool allyInRange(false);
+        TargetArena& arena(m_pManager->GetTargetArena());
+        TargetSpan& span(m_pStorage->m_targetSpan[m_index]);
 
-        for (int i = 0; i < MineManager::GetInstance().GetNumberOfObjects(); ++i)
+        arena.Release(aThreadIndex, span);
+
+        /* Selection only needs the count; with lazy lists, only mines that explode ever build theirs */
+        if (TL_COUNT == m_pManager->GetTargetListMode())
+        {
+            span = { 0, 0, 0, TE_HANDLES };
+            m_pStorage->m_numberOfTargets[m_index] = CollectTargets(turn, NULL, &allyInRange);
+        }
+        else
         {
-            Mine* pObject = MineManager::GetInstance().GetObjectByIndex(i);
+            std::vector<MineHandle>& buffer(arena.GetBuffer(aThreadIndex));
 
-            if (NULL != pObject && !Equals(*pObject))
-            {
-                float distance = Vector3::SqrDistance(pObject->GetPosition(), GetPosition());
-                if (pObject->IsInvulnerable() || distance > (m_destructiveRadius * m_destructiveRadius))
-                {
-                    break;
-                }
-
-                /* Dismiss allied mines when, throwing a coin into the air, it gets the desired value. 
-                In other words, if we get equal or less than 5%, allied mine will be save for at least a turn*/
-                if(pObject->GetTeam() == GetTeam() && GetRandomFloat32() <= 0.05f)
-                {
-                    break;
-                }
-
-                m_targetList.push_back(pObject);
-            }
+            span = { static_cast<unsigned int>(aThreadIndex), static_cast<unsigned int>(buffer.size()), 0, TE_HANDLES };
+            span.m_count = CollectTargets(turn, &buffer, &allyInRange);
+            m_pStorage->m_numberOfTargets[m_index] = span.m_count;
+
+            /* Dense lists are kept as bitsets. Lazy lists are read right away, they stay handles */
+            arena.Encode(aThreadIndex, span, m_pStorage->GetHandleClock());
         }
+
+        m_pStorage->m_targetPass[m_index] = turn;
+        m_pStorage->m_allyInRange[m_index] = allyInRange ? 1 : 0;
     }
 }
 
-void Mine::Explode()
+void Mine::BuildTargetList()
 {
-    if (!IsDestroyed())
+    TargetArena& arena(m_pManager->GetTargetArena());
+    const int sequentialBuffer(arena.GetSequentialBuffer());
+    std::vector<MineHandle>& buffer(arena.GetBuffer(sequentialBuffer));
+    TargetSpan& span(m_pStorage->m_targetSpan[m_index]);
+
+    arena.Release(sequentialBuffer, span);
+    span = { static_cast<unsigned int>(sequentialBuffer), static_cast<unsigned int>(buffer.size()), 0, TE_HANDLES };
+
+    /* Mines are only ever removed between passes, otherwise this mine would have been retargeted:
+    querying now finds the same targets, minus the ones gone since */
+    if (0 < m_pStorage->m_numberOfTargets[m_index])
+    {
+        span.m_count = CollectTargets(m_pStorage->m_targetPass[m_index], &buffer, NULL);
+    }
+}
+
+int Mine::CollectTargets(const unsigned int aPass, std::vector<MineHandle>* apTargetList, bool* apAllyInRange) const
+{
+    /* Candidate indexes, kept per thread to avoid reallocating every call */
+    static thread_local std::vector<int> s_candidates;
+
+    const MineStorage& storage(*m_pStorage);
+    const int team(storage.m_team[m_index]);
+    const unsigned int objectId(storage.m_objectId[m_index]);
+    const unsigned int seed(m_pManager->GetRandomSeed());
+    int numberOfTargets(0);
+    bool allyInRange(false);
+
+    s_candidates.clear();
+
+    /* Targeting backend only reports vulnerable mines already inside destructive radius */
+    m_pManager->QueryRadius(GetPosition(), storage.m_destructiveRadius[m_index], OBF_INVULNERABLE, s_candidates);
+
+    for (const int candidate : s_candidates)
     {
-        for (unsigned int i = 0; i < m_targetList.size(); ++i)
+        if (candidate == m_index)
         {
-            Mine* cachedMine(m_targetList[i]);
+            continue;
+        }
 
-            if (NULL != cachedMine && !cachedMine->IsInvalid())
-            {
-                float distance = Vector3::SqrDistance(cachedMine->GetPosition(), GetPosition());
+        /* Dismiss allied mines when, throwing a coin into the air, it gets the desired value. 
+        In other words, if we get equal or less than 5%, allied mine will be save for at least a turn.
+        The coin only depends on who throws it at whom and when, never on which thread does */
+        if (storage.m_team[candidate] == team)
+        {
+            allyInRange = true;
 
-                // damage is inverse-squared of distance
-                float factor = 1.0f - (distance / (m_destructiveRadius * m_destructiveRadius));
-                float damage = (factor * factor) * m_explosiveYield;
-                cachedMine->TakeDamage(damage);
+            if (GetCounterRandomFloat32(seed, aPass, objectId, storage.m_objectId[candidate]) <= 0.05f)
+            {
+                continue;
             }
         }
 
-        SetSelfDestroy();
-
-        // Destroy self
-        if (m_health > 0)
+        if (NULL != apTargetList)
         {
-           TakeDamage(m_health);
+            apTargetList->push_back(storage.m_handle[candidate]);
         }
+
+        numberOfTargets++;
+    }
+
+    if (NULL != apAllyInRange)
+    {
+        *apAllyInRange = allyInRange;
     }
+
+    return numberOfTargets;
+}
+
+void Mine::Explode()
+{
+    /* Chain reaction is resolved by the manager, which may move this very mine to another slot */
+    m_pManager->ResolveExplosion(m_index);
 }
 
 void Mine::TakeDamage(const float aDamage)
 {
-    m_health -= aDamage;
+    /* Already exploding or gone, it will be removed by its own Explode call */
+    if (IsDestroyed() || IsInvalid())
+    {
+        return;
+    }
+
+    float& health(m_pStorage->m_health[m_index]);
+
+    health -= aDamage;
 
-    if (m_health <= 0.0f)
+    if (health <= 0.0f)
     {
         Explode();
-        
-        MineManager::GetInstance().RemoveObject(this);
-        
-        SetInvalid();
     }
 }
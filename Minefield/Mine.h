@@ -1,13 +1,21 @@
 #pragma once
 
-#include "Object.h"
+#include "MineStorage.h"
 #include "Random.h"
 #include <vector>
 
-class Mine : public Object
+class MineManager;
+
+/// <summary>
+/// Lightweight view over a MineStorage slot. Mine data lives in the storage field arrays; a view only
+/// knows which slot it looks at. Views are owned by MineManager, one per slot, and keep their address
+/// for the whole run, so a Mine* always refers to whatever mine currently occupies that slot. Code that
+/// has to remember a particular mine across removals keeps its MineHandle instead.
+/// </summary>
+class Mine
 {
 public:
-    Mine(const int aMineID, const int aPoolID);
+    Mine(MineManager* apManager, MineStorage* apStorage, const int aIndex);
     ~Mine(void);
 
     /* Internal enums*/
@@ -16,7 +24,9 @@ public:
         OBF_ACTIVE = 0x0001,
         OBF_INVULNERABLE = 0x0002,
         OBF_SELFDESTROYED = 0x0004,
-        OBF_INVALIDATED = 0x0008
+        OBF_INVALIDATED = 0x0008,
+        /* Copy of a mine owned by another shard: targetable, but its damage and explosion are handled by the owner */
+        OBF_GHOST = 0x0010
     };
 
     /// <summary>
@@ -25,11 +35,18 @@ public:
     /// <param name="aDamage"></param>
     void  TakeDamage(const float aDamage);
     /// <summary>
-    /// Collects targets.
+    /// Collects targets, or only counts them when the manager keeps target lists lazily.
+    /// </summary>
+    /// <param name="aThreadIndex">int. Targeting thread, picks the target arena buffer the list goes to</param>
+    void  FindCurrentTargets(const int aThreadIndex);
+    /// <summary>
+    /// Builds the target list last counted by FindCurrentTargets, as that pass would have filled it.
+    /// Mines removed since are still skipped by whoever reads the list.
     /// </summary>
-    void  FindCurrentTargets(void);
+    void  BuildTargetList(void);
     /// <summary>
-    /// Performes explotion if applicable.
+    /// Performes explotion if applicable, along with the chain reaction it triggers. Exploded mines are
+    /// removed, so this view may look at a different mine afterwards.
     /// </summary>
     void  Explode(void);
 
@@ -38,71 +55,137 @@ public:
     /// Sets mine active or inactive.
     /// </summary>
     /// <param name="aActive">bool. If mine would be active or inactive</param>
-    void SetActive(bool aActive) { m_bitFlags = (aActive ? m_bitFlags | OBF_ACTIVE : m_bitFlags & ~OBF_ACTIVE); }
+    void SetActive(bool aActive) { BitFlags() = (aActive ? BitFlags() | OBF_ACTIVE : BitFlags() & ~OBF_ACTIVE); }
     /// <summary>
     /// Sets vulnerability flag.
     /// </summary>
     /// <param name="aVulnerabilty">bool. If it would be vunerable or not</param>
-    void SetVunerabilty(bool aVulnerabilty) { m_bitFlags = (aVulnerabilty ? m_bitFlags | OBF_INVULNERABLE : m_bitFlags & ~OBF_INVULNERABLE); }
-    /// <summary>
-    /// Sets Team, using Pool ID as equivalence.
-    /// </summary>
-    /// <param name="aTeam">int. Team ID</param>
-    void SetTeam(const int aTeam) { SetObjectPoolID(aTeam); }
+    void SetVunerabilty(bool aVulnerabilty) { BitFlags() = (aVulnerabilty ? BitFlags() | OBF_INVULNERABLE : BitFlags() & ~OBF_INVULNERABLE); }
     /// <summary>
     /// Sets health value.
     /// </summary>
     /// <param name="in_health">float. New health</param>
-    inline void SetHealth(const float aHealth) { m_health = aHealth; }
+    inline void SetHealth(const float aHealth) { m_pStorage->m_health[m_index] = aHealth; }
     /// <summary>
     /// Sets mine destructive radius.
     /// </summary>
     /// <param name="in_radius">float. Radius</param>
-    inline void SetDestructiveRadius(const float aRadius) { m_destructiveRadius = aRadius; };
+    inline void SetDestructiveRadius(const float aRadius) { m_pStorage->m_destructiveRadius[m_index] = aRadius; };
+    /// <summary>
+    /// Sets position. Targeting backend is not notified, only meant to be used before the mine is registered.
+    /// </summary>
+    /// <param name="aPosition">Vector3. New vector3 position</param>
+    inline void SetPosition(const Vector3& aPosition) { m_pStorage->SetPosition(m_index, aPosition); }
     /// <summary>
     /// Invalidates mine
     /// </summary>
-    inline void SetInvalid(void) { m_bitFlags = OBF_INVALIDATED; }
+    inline void SetInvalid(void) { BitFlags() = OBF_INVALIDATED; }
     /// <summary>
     /// Set mine as destroyed (after self destroy)
     /// </summary>
-    inline void SetSelfDestroy(void) { m_bitFlags |= OBF_SELFDESTROYED; }
+    inline void SetSelfDestroy(void) { BitFlags() |= OBF_SELFDESTROYED; }
     /* Getters */
     /// <summary>
+    /// Returns Object ID.
+    /// </summary>
+    /// <returns>unsigned int. Unique ID</returns>
+    inline unsigned int GetObjectId(void) const { return m_pStorage->m_objectId[m_index]; }
+    /// <summary>
+    /// Returns pool ID, which is the team the mine belongs to.
+    /// </summary>
+    /// <returns>int. Pool ID</returns>
+    inline int GetObjectPoolID(void) const { return GetTeam(); }
+    /// <summary>
     /// Returns Mine team ID
     /// </summary>
     /// <returns>int. Team ID</returns>
-    inline const int GetTeam(void) const { return GetObjectPoolID(); }
+    inline int GetTeam(void) const { return m_pStorage->m_team[m_index]; }
+    /// <summary>
+    /// Returns mine position.
+    /// </summary>
+    /// <returns>Vector3. Mine vector3 pos</returns>
+    inline Vector3 GetPosition(void) const { return m_pStorage->GetPosition(m_index); }
+    /// <summary>
+    /// Returns mine destructive radius.
+    /// </summary>
+    /// <returns>float. Radius</returns>
+    inline float GetDestructiveRadius(void) const { return m_pStorage->m_destructiveRadius[m_index]; }
+    /// <summary>
+    /// Returns remaining health.
+    /// </summary>
+    /// <returns>float. Health</returns>
+    inline float GetHealth(void) const { return m_pStorage->m_health[m_index]; }
+    /// <summary>
+    /// Returns damage dealt at blast center.
+    /// </summary>
+    /// <returns>float. Explosive yield</returns>
+    inline float GetExplosiveYield(void) const { return m_pStorage->m_explosiveYield[m_index]; }
+    /// <summary>
+    /// Returns raw state flags (ObjectBitFlags).
+    /// </summary>
+    /// <returns>unsigned char. Bit flags</returns>
+    inline unsigned char GetBitFlags(void) const { return BitFlags(); }
+    /// <summary>
+    /// Returns handle of the mine currently in this slot. Unlike the view, it stays bound to that mine.
+    /// </summary>
+    /// <returns>MineHandle. Generational handle</returns>
+    inline MineHandle GetHandle(void) const { return m_pStorage->m_handle[m_index]; }
+    /// <summary>
+    /// Returns storage slot this view looks at.
+    /// </summary>
+    /// <returns>int. Slot index</returns>
+    inline int GetIndex(void) const { return m_index; }
     /// <summary>
     /// Returns current object vulnerability state.
     /// </summary>
     /// <returns>bool. If mines is vunerable or not</returns>
-    inline bool IsInvulnerable(void) const { return (m_bitFlags & OBF_INVULNERABLE) == OBF_INVULNERABLE; }
+    inline bool IsInvulnerable(void) const { return (BitFlags() & OBF_INVULNERABLE) == OBF_INVULNERABLE; }
     /// <summary>
     /// Returns object primarialy state
     /// </summary>
     /// <returns>bool. If mine is active or not</returns>
-    inline bool IsActive(void) const { return m_bitFlags & OBF_ACTIVE; }
+    inline bool IsActive(void) const { return (BitFlags() & OBF_ACTIVE) == OBF_ACTIVE; }
     /// <summary>
     /// If mine is already destroyed.
     /// </summary>
     /// <returns>bool. If mine was destroyed or not</returns>
-    inline bool IsDestroyed(void) const { return (m_bitFlags & OBF_SELFDESTROYED) == OBF_SELFDESTROYED; }
+    inline bool IsDestroyed(void) const { return (BitFlags() & OBF_SELFDESTROYED) == OBF_SELFDESTROYED; }
     /// <summary>
     /// If mine is already destroyed.
     /// </summary>
     /// <returns>bool. If mine was destroyed or not</returns>
-    inline bool IsInvalid(void) const { return (m_bitFlags & OBF_INVALIDATED) == OBF_INVALIDATED; }
+    inline bool IsInvalid(void) const { return (BitFlags() & OBF_INVALIDATED) == OBF_INVALIDATED; }
+    /// <summary>
+    /// If mine is a copy of a mine owned by another shard.
+    /// </summary>
+    /// <returns>bool. If mine is a ghost or not</returns>
+    inline bool IsGhost(void) const { return (BitFlags() & OBF_GHOST) == OBF_GHOST; }
     /// <summary>
     /// Returns Mine targest.
     /// </summary>
     /// <returns>int. Number of targets</returns>
-    inline int GetNumberOfTargets(void) const { return static_cast<int>(m_targetList.size()); }
+    inline int GetNumberOfTargets(void) const { return m_pStorage->m_numberOfTargets[m_index]; }
+    /// <summary>
+    /// Compares ID againts other mine ID.
+    /// </summary>
+    /// <param name="aToCompare">const Mine&. Mine reference</param>
+    /// <returns>bool. True if they are equal, false otherwise</returns>
+    inline bool Equals(const Mine& aToCompare) const { return aToCompare.GetObjectId() == GetObjectId(); }
 
 private:
-    float m_destructiveRadius;
-    float m_health;
-    float m_explosiveYield;
-    unsigned char m_bitFlags;
-    std::vector<Mine*> m_targetList;
+    /// <summary>
+    /// Queries mines within destructive radius and keeps those this mine targets in pass aPass.
+    /// </summary>
+    /// <param name="aPass">unsigned int. Targeting pass, decides which allies are spared</param>
+    /// <param name="apTargetList">std::vector<MineHandle>*. Targets are appended to it, NULL to only count them</param>
+    /// <param name="apAllyInRange">bool*. Set if an ally lies within destructive radius, spared or not. May be NULL</param>
+    /// <returns>int. Number of targets</returns>
+    int   CollectTargets(const unsigned int aPass, std::vector<MineHandle>* apTargetList, bool* apAllyInRange) const;
+
+    inline unsigned char& BitFlags(void) { return m_pStorage->m_bitFlags[m_index]; }
+    inline unsigned char  BitFlags(void) const { return m_pStorage->m_bitFlags[m_index]; }
+
+    MineManager* m_pManager;
+    MineStorage* m_pStorage;
+    int          m_index;
 };
@@ -1,9 +1,38 @@
 #include "stdafx.h"
 #include "MineManager.h"
 #include "Mine.h"
+#include "MineSnapshot.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
 #include <algorithm>
+#include <functional>
+#include <string.h>
 
-MineManager::MineManager()
+namespace
+{
+    /* Half of the mean destructive radius: an average query spans ~5 cells per axis, which keeps
+    both the number of visited cells and the candidates falling outside the sphere low */
+    const float cSpatialGridCellSize = (cMinDestructiveRadius + cMaxDestructiveRadius) * 0.25f;
+    /* Once changes outnumber 1/cFullRetargetRatio of the field, querying around each of them costs
+    more than retargeting every mine (first turn, or respawning a whole team) */
+    const int cFullRetargetRatio = 4;
+    /* Share of the radius range, at either end, small and large radii are drawn from */
+    const float cRadiusBandFraction = 0.2f;
+    const char* const cRadiusDistributionNames[] = { "uniform", "small", "large", "bimodal" };
+}
+
+static_assert(cMaximumNumberOfObjects <= static_cast<int>(cMineHandleIndexMask), "Mine handles cannot address every object");
+
+MineManager::MineManager() :
+    m_pSpatialIndex(SpatialIndex::Create(TB_SPATIAL_GRID, m_storage, cSpatialGridCellSize))
+  , m_targetingBackend(TB_SPATIAL_GRID)
+  , m_incrementalTargeting(true)
+  , m_targetListMode(TL_FULL)
+  , m_radiusDistribution(RD_UNIFORM)
+  , m_targetingPass(0)
+  , m_randomSeed(0)
+  , m_targetRanking(m_storage)
+  , m_targetRankingStale(false)
 {
 }
 
@@ -12,69 +41,526 @@ MineManager::~MineManager()
     Dispose();
 }
 
-const Mine* MineManager::AddMineObject(const unsigned int aObjectId, const Vector3 aPosition, const int aTeam)
+void MineManager::Init(const int aPools, const int aObjectPerPool)
+{
+    ObjectManager<Mine>::Init(aPools, aObjectPerPool);
+
+    m_storage.Reserve(std::min(aPools * aObjectPerPool, cMaximumNumberOfObjects));
+    m_slotOfObjectId.reserve(std::min(aPools * aObjectPerPool, cMaximumNumberOfObjects));
+}
+
+void MineManager::SetTargetingBackend(const TargetingBackend aBackend)
 {
     MutexLock lock(m_lock);
 
-    /* If not team defined, then added, otherwise, retrieve*/
-    auto& cachedTeam = m_mObject[aTeam];
+    m_targetingBackend = aBackend;
+    m_pSpatialIndex.reset(SpatialIndex::Create(aBackend, m_storage, cSpatialGridCellSize));
+
+    RebuildSpatialIndex();
+}
+
+void MineManager::PrepareTargeting(const int aNumberOfThreads)
+{
+    m_pSpatialIndex->Refresh();
+
+    const int numberOfMines(m_storage.GetSize());
+
+    m_retargetQueue.clear();
+
+    if (!m_incrementalTargeting || static_cast<int>(m_changedPositions.size()) * cFullRetargetRatio >= numberOfMines)
+    {
+        m_retargetQueue.reserve(numberOfMines);
+
+        for (int i = 0; i < numberOfMines; ++i)
+        {
+            m_retargetQueue.push_back(i);
+        }
+    }
+    else
+    {
+        /* Only shrinks between passes, and marks are reset below, so it is all zeros */
+        m_queued.resize(numberOfMines, 0);
+
+        for (const Vector3& position : m_changedPositions)
+        {
+            m_candidates.clear();
+            m_pSpatialIndex->QueryRadius(position, cMaxDestructiveRadius, 0, m_candidates);
+
+            /* Same test, same operand order, as the one the mine runs on its own targeting query */
+            for (const int candidate : m_candidates)
+            {
+                const float radius(m_storage.m_destructiveRadius[candidate]);
+
+                if (Vector3::SqrDistance(position, m_storage.GetPosition(candidate)) <= radius * radius)
+                {
+                    m_queued[candidate] = 1;
+                }
+            }
+        }
+
+        /* Mines with an ally in range throw their coin again every pass, as a full pass would, so their
+        lists never freeze on an old draw. Queued in slot order, which keeps storage access roughly
+        sequential for the workers */
+        for (int i = 0; i < numberOfMines; ++i)
+        {
+            if (m_queued[i] || m_storage.m_allyInRange[i])
+            {
+                m_retargetQueue.push_back(i);
+            }
+
+            m_queued[i] = 0;
+        }
+    }
+
+    m_targetArena.Reserve(aNumberOfThreads);
+
+    /* Lists about to be rebuilt are garbage already: once garbage outweighs what is left, move the rest
+    aside and start the buffers over. Every pass when every mine is retargeted, with nothing to move */
+    size_t numberOfReleasedEntries(m_targetArena.GetNumberOfReleasedEntries());
+
+    for (const int index : m_retargetQueue)
+    {
+        numberOfReleasedEntries += m_storage.m_targetSpan[index].m_count;
+    }
+
+    if (2 * numberOfReleasedEntries >= m_targetArena.GetNumberOfEntries())
+    {
+        for (const int index : m_retargetQueue)
+        {
+            m_storage.m_targetSpan[index] = { 0, 0, 0, TE_HANDLES };
+        }
+
+        m_targetArena.Compact(m_storage.m_targetSpan);
+    }
+
+    m_changedPositions.clear();
+    m_targetRankingStale = true;
+    m_targetingPass++;
+}
+
+void MineManager::FlushTargetRanking(void)
+{
+    if (m_targetRankingStale)
+    {
+        if (static_cast<int>(m_retargetQueue.size()) * cFullRetargetRatio >= m_storage.GetSize())
+        {
+            m_targetRanking.Rebuild();
+        }
+        else
+        {
+            for (const int index : m_retargetQueue)
+            {
+                m_targetRanking.Update(index);
+            }
+        }
+
+        m_targetRankingStale = false;
+    }
+}
+
+const Mine* MineManager::AddMineObject(const unsigned int aObjectId, const Vector3 aPosition, const int aTeam)
+{
+    MutexLock lock(m_lock);
 
     /* Verify if object exists */
     Mine* resultObj(GetObjectByID(aObjectId));
 
-    /* If so, then it is remove from previous pool to be respawned into a different one. */
+    /* If so, then it is removed to be respawned into a different team. */
     if (NULL != resultObj)
     {
         RemoveObject(resultObj);
+        resultObj = NULL;
     }
 
     /* Create a new mine*/
     if (m_numberOfObjects < cMaximumNumberOfObjects)
     {
-        /* To avoid extra copies */
-        AddObject(aObjectId, aTeam);
-
-        resultObj = &cachedTeam.back();
+        /* Configured before insertion so it lands into the right spatial index cell */
+        resultObj = &m_views[AllocateSlot(aObjectId, aTeam)];
 
-        resultObj->SetTeam(aTeam);
         resultObj->SetPosition(aPosition);
-        resultObj->SetDestructiveRadius(GetRandomFloat32_Range(100.0f, 1000.0f));
+        resultObj->SetDestructiveRadius(GetRandomFloat32_Range(cMinDestructiveRadius, cMaxDestructiveRadius));
         resultObj->SetActive(GetRandomFloat32() < 0.95f);
         resultObj->SetVunerabilty(GetRandomFloat32() < 0.1f);
+
+        m_pSpatialIndex->Insert(resultObj->GetIndex(), aPosition);
+        m_changedPositions.push_back(aPosition);
     }
 
     return resultObj;
 }
 
+int MineManager::AddMines(const int aCount, const MineSpawnGenerator& aGenerator, WorkerPool& aPool)
+{
+    MutexLock lock(m_lock);
+
+    std::vector<MineSpawn> spawns(std::max(aCount, 0));
+
+    aPool.ParallelFor(static_cast<int>(spawns.size()), [&spawns, &aGenerator](int aBegin, int aEnd, int)
+    {
+        for (int i = aBegin; i < aEnd; ++i)
+        {
+            aGenerator(i, spawns[i]);
+        }
+    });
+
+    /* Same outcome as spawning one by one: only the last spawn of an ID survives, and a mine already
+    owning it is respawned */
+    std::unordered_map<unsigned int, int> lastSpawnOfId;
+    std::vector<int> accepted;
+
+    lastSpawnOfId.reserve(spawns.size());
+    accepted.reserve(spawns.size());
+
+    for (int i = 0; i < static_cast<int>(spawns.size()); ++i)
+    {
+        lastSpawnOfId[spawns[i].m_objectId] = i;
+    }
+
+    for (int i = 0; i < static_cast<int>(spawns.size()); ++i)
+    {
+        if (i == lastSpawnOfId[spawns[i].m_objectId])
+        {
+            const Mine* pExisting(GetObjectByID(spawns[i].m_objectId));
+
+            if (NULL != pExisting)
+            {
+                EraseSlot(pExisting->GetIndex());
+            }
+
+            accepted.push_back(i);
+        }
+    }
+
+    accepted.resize(std::min(static_cast<int>(accepted.size()), cMaximumNumberOfObjects - m_numberOfObjects));
+
+    const int first(m_storage.GetSize());
+
+    for (const int spawn : accepted)
+    {
+        AllocateSlot(spawns[spawn].m_objectId, spawns[spawn].m_team);
+    }
+
+    /* Slots are preallocated, every thread writes its own range of them */
+    aPool.ParallelFor(static_cast<int>(accepted.size()), [this, first, &spawns, &accepted](int aBegin, int aEnd, int)
+    {
+        for (int i = aBegin; i < aEnd; ++i)
+        {
+            const unsigned int ordinal(static_cast<unsigned int>(accepted[i]));
+            const int index(first + i);
+
+            m_storage.SetPosition(index, spawns[accepted[i]].m_position);
+            DrawSpawnProperties(m_randomSeed, ordinal, m_radiusDistribution, m_storage.m_destructiveRadius[index], m_storage.m_bitFlags[index]);
+        }
+    });
+
+    for (int index = first; index < m_storage.GetSize(); ++index)
+    {
+        m_pSpatialIndex->Insert(index, m_storage.GetPosition(index));
+        m_changedPositions.push_back(m_storage.GetPosition(index));
+    }
+
+    return first;
+}
+
+int MineManager::AddMineRecords(const MineRecord* aRecords, const int aCount)
+{
+    MutexLock lock(m_lock);
+
+    int numberOfMinesAdded(0);
+
+    for (int i = 0; i < aCount && m_numberOfObjects < cMaximumNumberOfObjects; ++i)
+    {
+        const MineRecord& record(aRecords[i]);
+        const Mine* pExisting(GetObjectByID(record.m_objectId));
+
+        if (NULL != pExisting)
+        {
+            EraseSlot(pExisting->GetIndex());
+        }
+
+        const int index(AllocateSlot(record.m_objectId, record.m_team));
+
+        m_storage.SetPosition(index, record.m_position);
+        m_storage.m_destructiveRadius[index] = record.m_destructiveRadius;
+        m_storage.m_bitFlags[index] = record.m_bitFlags;
+
+        /* Ghosts are only there to be targeted, their owner picks them */
+        if (record.m_bitFlags & Mine::OBF_GHOST)
+        {
+            m_targetRanking.Remove(index);
+        }
+
+        m_pSpatialIndex->Insert(index, record.m_position);
+        m_changedPositions.push_back(record.m_position);
+
+        numberOfMinesAdded++;
+    }
+
+    return numberOfMinesAdded;
+}
+
+void MineManager::LoadSnapshot(const MineSnapshot& aSnapshot)
+{
+    MutexLock lock(m_lock);
+
+    Dispose();
+
+    const int numberOfMines(std::min(aSnapshot.GetNumberOfMines(), cMaximumNumberOfObjects));
+    const int first(m_storage.AddRange(numberOfMines));
+
+    if (numberOfMines > 0)
+    {
+        memcpy(&m_storage.m_objectId[first], aSnapshot.GetSection(SS_OBJECT_ID), numberOfMines * sizeof(unsigned int));
+        memcpy(&m_storage.m_team[first], aSnapshot.GetSection(SS_TEAM), numberOfMines * sizeof(int));
+        memcpy(&m_storage.m_positionX[first], aSnapshot.GetSection(SS_POSITION_X), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_positionY[first], aSnapshot.GetSection(SS_POSITION_Y), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_positionZ[first], aSnapshot.GetSection(SS_POSITION_Z), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_destructiveRadius[first], aSnapshot.GetSection(SS_DESTRUCTIVE_RADIUS), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_health[first], aSnapshot.GetSection(SS_HEALTH), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_explosiveYield[first], aSnapshot.GetSection(SS_EXPLOSIVE_YIELD), numberOfMines * sizeof(float));
+        memcpy(&m_storage.m_bitFlags[first], aSnapshot.GetSection(SS_BIT_FLAGS), numberOfMines * sizeof(unsigned char));
+    }
+
+    /* Views are never destroyed, a slot reused later keeps its view */
+    while (static_cast<int>(m_views.size()) < m_storage.GetSize())
+    {
+        m_views.emplace_back(this, &m_storage, static_cast<int>(m_views.size()));
+    }
+
+    m_slotOfObjectId.reserve(numberOfMines);
+
+    for (int index = first; index < m_storage.GetSize(); ++index)
+    {
+        m_numberOfObjectsPerTeam[m_storage.m_team[index]]++;
+        m_slotOfObjectId[m_storage.m_objectId[index]] = index;
+        m_targetRanking.Insert(index);
+        m_pSpatialIndex->Insert(index, m_storage.GetPosition(index));
+        m_changedPositions.push_back(m_storage.GetPosition(index));
+    }
+
+    m_numberOfObjects = m_storage.GetSize();
+}
+
 Mine* MineManager::GetObjectWithMostEnemyTargets(const int aTeam)
 {
-    Mine* out_pObject = NULL;
+    FlushTargetRanking();
+
+    const int index(m_targetRanking.GetTop(aTeam));
+
+    return index >= 0 ? &m_views[index] : NULL;
+}
+
+void MineManager::ResolveExplosion(const int aIndex)
+{
+    if (aIndex < 0 || aIndex >= m_storage.GetSize() || (m_storage.m_bitFlags[aIndex] & Mine::OBF_SELFDESTROYED))
+    {
+        return;
+    }
+
+    m_explosionQueue.clear();
 
-    auto cachedTeam = m_mObject.find(aTeam);
+    /* Flagged when queued, so nothing explodes twice however many blasts reach it */
+    m_storage.m_bitFlags[aIndex] |= Mine::OBF_SELFDESTROYED;
+    m_explosionQueue.push_back(aIndex);
 
-    if (std::end(m_mObject) != cachedTeam && (*cachedTeam).second.size() > 0)
     {
-        out_pObject = &(*std::max_element((*cachedTeam).second.begin(), (*cachedTeam).second.end(), [](const Mine& aObjectLeft, const Mine& aObjectRight) {
-                return aObjectLeft.GetNumberOfTargets() < aObjectRight.GetNumberOfTargets();
-            }));
+        ProfileScope chainReactionScope(PZ_CHAIN_REACTION);
+
+        for (size_t head = 0; head < m_explosionQueue.size(); ++head)
+        {
+            const int index(m_explosionQueue[head]);
+
+            if (TL_COUNT == m_targetListMode)
+            {
+                m_views[index].BuildTargetList();
+            }
+
+            const Vector3 position(m_storage.GetPosition(index));
+            const float sqrRadius(m_storage.m_destructiveRadius[index] * m_storage.m_destructiveRadius[index]);
+            const float explosiveYield(m_storage.m_explosiveYield[index]);
+            const TargetSpan span(m_storage.m_targetSpan[index]);
+            /* Nothing is appended to the arena until the next list is built */
+            const MineHandle* pTargets(m_targetArena.GetEntries(span));
+
+            const auto blast = [&](const int aTarget)
+            {
+                /* Exploded mines are already queued and no longer take damage */
+                if (aTarget < 0 || (m_storage.m_bitFlags[aTarget] & (Mine::OBF_SELFDESTROYED | Mine::OBF_INVALIDATED)))
+                {
+                    return;
+                }
+
+                float distance = Vector3::SqrDistance(m_storage.GetPosition(aTarget), position);
+
+                // damage is inverse-squared of distance
+                float factor = 1.0f - (distance / sqrRadius);
+
+                if (m_storage.m_bitFlags[aTarget] & Mine::OBF_GHOST)
+                {
+                    m_remoteDamage.push_back({ m_storage.m_objectId[aTarget], (factor * factor) * explosiveYield });
+                    return;
+                }
+
+                float& health(m_storage.m_health[aTarget]);
+
+                health -= (factor * factor) * explosiveYield;
+
+                if (health <= 0.0f)
+                {
+                    m_storage.m_bitFlags[aTarget] |= Mine::OBF_SELFDESTROYED;
+                    m_explosionQueue.push_back(aTarget);
+                }
+            };
+
+            if (TE_BITSET == span.m_encoding)
+            {
+                /* Walked straight from the words, in handle table order */
+                const unsigned int firstEntry(pTargets[0] * 32);
+                const unsigned int handleClock(pTargets[1]);
+
+                for (unsigned int word = cTargetBitsetHeaderSize; word < span.m_count; ++word)
+                {
+                    for (unsigned int bits = pTargets[word]; 0 != bits; bits &= bits - 1)
+                    {
+                        const unsigned int entry(firstEntry + (word - cTargetBitsetHeaderSize) * 32 + TargetArena::GetLowestBit(bits));
+
+                        blast(m_storage.ResolveEntry(entry, handleClock));
+                    }
+                }
+            }
+            else
+            {
+                for (unsigned int i = 0; i < span.m_count; ++i)
+                {
+                    blast(m_storage.Resolve(pTargets[i]));
+                }
+            }
+        }
     }
 
-    return out_pObject;
+    ProfileScope removalScope(PZ_REMOVAL);
+
+    /* Highest slot first: EraseSlot only ever moves the last mine down into the hole, which is then
+    never one of the slots still pending */
+    std::sort(m_explosionQueue.begin(), m_explosionQueue.end(), std::greater<int>());
+
+    for (const int index : m_explosionQueue)
+    {
+        EraseSlot(index);
+    }
+}
+
+void MineManager::TakeRemoteDamage(std::vector<MineDamage>& aOut)
+{
+    aOut.clear();
+    aOut.swap(m_remoteDamage);
+}
+
+const char* MineManager::GetTargetListModeName(const TargetListMode aMode)
+{
+    return TL_COUNT == aMode ? "count" : "full";
+}
+
+bool MineManager::ParseTargetListMode(const char* aName, TargetListMode& aOutMode)
+{
+    if (0 == strcmp(aName, "full") || 0 == strcmp(aName, "count"))
+    {
+        aOutMode = 0 == strcmp(aName, "count") ? TL_COUNT : TL_FULL;
+        return true;
+    }
+
+    return false;
+}
+
+const char* MineManager::GetRadiusDistributionName(const RadiusDistribution aDistribution)
+{
+    return aDistribution >= RD_UNIFORM && aDistribution <= RD_BIMODAL ? cRadiusDistributionNames[aDistribution] : "unknown";
+}
+
+bool MineManager::ParseRadiusDistribution(const char* aName, RadiusDistribution& aOutDistribution)
+{
+    for (int distribution = RD_UNIFORM; distribution <= RD_BIMODAL; distribution++)
+    {
+        if (0 == strcmp(aName, cRadiusDistributionNames[distribution]))
+        {
+            aOutDistribution = static_cast<RadiusDistribution>(distribution);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MineManager::DrawSpawnProperties(const unsigned int aSeed, const unsigned int aOrdinal, const RadiusDistribution aRadiusDistribution,
+                                      float& aDestructiveRadius, unsigned char& aBitFlags)
+{
+    const float range(cMaxDestructiveRadius - cMinDestructiveRadius);
+    float low(cMinDestructiveRadius);
+    float high(cMaxDestructiveRadius);
+
+    switch (aRadiusDistribution)
+    {
+    case RD_SMALL:
+        high = cMinDestructiveRadius + cRadiusBandFraction * range;
+        break;
+    case RD_LARGE:
+        low = cMaxDestructiveRadius - cRadiusBandFraction * range;
+        break;
+    case RD_BIMODAL:
+        /* Own draw for the mode, so the radius draw stays the one the other distributions use */
+        if (GetCounterRandomFloat32(aSeed, RS_SPAWN_PROPERTIES, aOrdinal, 3) < 0.5f)
+        {
+            high = cMinDestructiveRadius + cRadiusBandFraction * range;
+        }
+        else
+        {
+            low = cMaxDestructiveRadius - cRadiusBandFraction * range;
+        }
+        break;
+    default:
+        break;
+    }
+
+    aDestructiveRadius = low + GetCounterRandomFloat32(aSeed, RS_SPAWN_PROPERTIES, aOrdinal, 0) * (high - low);
+    aBitFlags =
+        (GetCounterRandomFloat32(aSeed, RS_SPAWN_PROPERTIES, aOrdinal, 1) < 0.95f ? Mine::OBF_ACTIVE : 0) |
+        (GetCounterRandomFloat32(aSeed, RS_SPAWN_PROPERTIES, aOrdinal, 2) < 0.1f ? Mine::OBF_INVULNERABLE : 0);
+}
+
+bool MineManager::Contains(const Mine* apObject) const
+{
+    return NULL != apObject && apObject->GetIndex() < m_storage.GetSize() && &m_views[apObject->GetIndex()] == apObject;
 }
 
 int MineManager::GetNumberOfObjectForTeam(int aTeam)
 {
-    auto cachedTeam = m_mObject.find(aTeam);
+    auto cachedTeam = m_numberOfObjectsPerTeam.find(aTeam);
 
-    return std::end(m_mObject) != cachedTeam ? static_cast<int>((*cachedTeam).second.size()) : 0;
+    return std::end(m_numberOfObjectsPerTeam) != cachedTeam ? (*cachedTeam).second : 0;
 }
 
 void MineManager::AddObject(const Mine* in_object)
 {
     if (NULL != in_object)
     {
-        m_numberOfObjects++;
-        m_mObject[in_object->GetObjectPoolID()].push_back(*in_object);
+        /* Source view may belong to this very storage, read every field before growing it */
+        const Vector3 position(in_object->GetPosition());
+        const float destructiveRadius(in_object->GetDestructiveRadius());
+        const float health(in_object->GetHealth());
+        const float explosiveYield(in_object->GetExplosiveYield());
+        const unsigned char bitFlags(in_object->GetBitFlags());
+
+        const int index(AllocateSlot(in_object->GetObjectId(), in_object->GetTeam()));
+
+        m_storage.SetPosition(index, position);
+        m_storage.m_destructiveRadius[index] = destructiveRadius;
+        m_storage.m_health[index] = health;
+        m_storage.m_explosiveYield[index] = explosiveYield;
+        m_storage.m_bitFlags[index] = bitFlags;
+
+        m_pSpatialIndex->Insert(index, position);
+        m_changedPositions.push_back(position);
     }
     else
     {
@@ -84,25 +570,19 @@ void MineManager::AddObject(const Mine* in_object)
 
 void MineManager::AddObject(const int objectId, const int poolID)
 {
-    m_numberOfObjects++;
+    const int index(AllocateSlot(objectId, poolID));
 
-    m_mObject[poolID].emplace_back(objectId, poolID);
+    m_pSpatialIndex->Insert(index, m_storage.GetPosition(index));
+    m_changedPositions.push_back(m_storage.GetPosition(index));
 }
 
 void MineManager::RemoveObject(const Mine* in_object)
 {
     if (NULL != in_object)
     {
-        auto& cachedPool(m_mObject[in_object->GetObjectPoolID()]);
-
-        const auto& it(std::find_if(cachedPool.begin(), cachedPool.end(), [&](const Mine& object) {
-                return in_object->GetObjectId() == object.GetObjectId();
-            }));
-
-        if (std::end(cachedPool) != it)
+        if (Contains(in_object))
         {
-            m_numberOfObjects--;
-            cachedPool.erase(it);
+            EraseSlot(in_object->GetIndex());
         }
     }
     else
@@ -113,34 +593,19 @@ void MineManager::RemoveObject(const Mine* in_object)
 
 void MineManager::RemoveById(const int in_objectID)
 {
-    for (auto& cachedMap : m_mObject)
-    {
-        const auto& it(std::find_if(cachedMap.second.begin(), cachedMap.second.end(), [&](const Mine& object) {
-                return in_objectID == object.GetObjectId();
-            }));
+    const Mine* pObject(GetObjectByID(in_objectID));
 
-        if (std::end(cachedMap.second) != it)
-        {
-            cachedMap.second.erase(it);
-            m_numberOfObjects--;
-            break;
-        }
+    if (NULL != pObject)
+    {
+        EraseSlot(pObject->GetIndex());
     }
 }
 
 void MineManager::RemoveByIndex(const int in_index)
 {
-    if (in_index < m_numberOfObjects)
+    if (in_index >= 0 && in_index < m_storage.GetSize())
     {
-        const auto indexData = GetObjectIndex(in_index);
-
-        auto& cachedMap(m_mObject[indexData.m_poolID]);
-
-        if (indexData.m_actualIndex < static_cast<int>(cachedMap.size()))
-        {
-            m_numberOfObjects--;
-            cachedMap.erase(cachedMap.begin() + indexData.m_actualIndex);
-        }
+        EraseSlot(in_index);
     }
 }
 
@@ -148,14 +613,11 @@ Mine* MineManager::GetObjectByID(const int in_objectID)
 {
     Mine* out_result = NULL;
 
-    for (auto& cachedMap : m_mObject)
-    {
-        const auto& it = std::find_if(cachedMap.second.begin(), cachedMap.second.end(), [&](const Mine& object) {
-                return in_objectID == object.GetObjectId();
-            });
+    const auto& it = m_slotOfObjectId.find(static_cast<unsigned int>(in_objectID));
 
-        if (std::end(cachedMap.second) != it)
-            out_result = &(*it);
+    if (std::end(m_slotOfObjectId) != it)
+    {
+        out_result = &m_views[(*it).second];
     }
 
     return out_result;
@@ -165,16 +627,9 @@ Mine* MineManager::GetObjectByIndex(const int in_Index)
 {
     Mine* out_result = NULL;
 
-    if (in_Index < m_numberOfObjects)
+    if (in_Index >= 0 && in_Index < m_storage.GetSize())
     {
-        const auto indexData = GetObjectIndex(in_Index);
-
-        auto& cachedMap(m_mObject[indexData.m_poolID]);
-
-        if (indexData.m_actualIndex < static_cast<int>(cachedMap.size()))
-        {
-            out_result = &cachedMap[indexData.m_actualIndex];
-        }
+        out_result = &m_views[in_Index];
     }
     else
     {
@@ -186,10 +641,92 @@ Mine* MineManager::GetObjectByIndex(const int in_Index)
 
 void MineManager::Dispose(void)
 {
-    for (auto& keyVal : m_mObject)
+    m_storage.Clear();
+    m_numberOfObjectsPerTeam.clear();
+    m_slotOfObjectId.clear();
+    m_changedPositions.clear();
+    m_retargetQueue.clear();
+    m_remoteDamage.clear();
+    m_targetRanking.Clear();
+    m_targetRankingStale = false;
+    m_targetArena.Clear();
+    m_targetingPass = 0;
+    m_numberOfObjects = 0;
+
+    m_pSpatialIndex->Clear();
+}
+
+int MineManager::AllocateSlot(const unsigned int aObjectId, const int aTeam)
+{
+    const int index(m_storage.Add(aObjectId, aTeam));
+
+    /* Views are never destroyed, a slot reused later keeps its view */
+    while (static_cast<int>(m_views.size()) <= index)
+    {
+        m_views.emplace_back(this, &m_storage, static_cast<int>(m_views.size()));
+    }
+
+    m_numberOfObjectsPerTeam[aTeam]++;
+    m_numberOfObjects++;
+    m_slotOfObjectId[aObjectId] = index;
+
+    FlushTargetRanking();
+    m_targetRanking.Insert(index);
+
+    return index;
+}
+
+void MineManager::EraseSlot(const int aIndex)
+{
+    const int last(m_storage.GetSize() - 1);
+
+    /* Retargeted lists must be ranked before entries start moving around, the queue holds slot indexes */
+    FlushTargetRanking();
+    m_targetRanking.Remove(aIndex);
+
+    m_pSpatialIndex->Remove(aIndex, m_storage.GetPosition(aIndex));
+    m_changedPositions.push_back(m_storage.GetPosition(aIndex));
+
+    /* Storage fills the hole with the last mine: O(1) and only one spatial index entry to patch.
+    Target lists hold handles, which follow the moved mine, so they need no retargeting */
+    if (aIndex != last)
+    {
+        m_pSpatialIndex->Relocate(last, aIndex, m_storage.GetPosition(last));
+    }
+
+    m_numberOfObjectsPerTeam[m_storage.m_team[aIndex]]--;
+    m_numberOfObjects--;
+    m_targetArena.Release(m_targetArena.GetSequentialBuffer(), m_storage.m_targetSpan[aIndex]);
+
+    /* Only forget the ID if it still maps here, a duplicate added through AddObject may own it */
+    const auto& id(m_slotOfObjectId.find(m_storage.m_objectId[aIndex]));
+
+    if (std::end(m_slotOfObjectId) != id && aIndex == (*id).second)
     {
-        keyVal.second.clear();
+        m_slotOfObjectId.erase(id);
     }
 
-    m_mObject.clear();
-}
\ No newline at end of file
+    m_storage.Remove(aIndex);
+
+    if (aIndex != last)
+    {
+        const auto& movedId(m_slotOfObjectId.find(m_storage.m_objectId[aIndex]));
+
+        if (std::end(m_slotOfObjectId) != movedId && last == (*movedId).second)
+        {
+            (*movedId).second = aIndex;
+        }
+
+        m_targetRanking.Relocate(last, aIndex);
+    }
+}
+
+void MineManager::RebuildSpatialIndex(void)
+{
+    m_pSpatialIndex->Clear();
+
+    for (int i = 0; i < m_storage.GetSize(); ++i)
+    {
+        m_pSpatialIndex->Insert(i, m_storage.GetPosition(i));
+    }
+}
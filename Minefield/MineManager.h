@@ -1,23 +1,304 @@
 #pragma once
 #include "ObjectManager.h"
+#include "SpatialIndex.h"
+#include "MineStorage.h"
+#include "TargetArena.h"
+#include "TargetRanking.h"
+#include "Mine.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 
-class Mine;
-struct Vector3;
+class MineSnapshot;
+class WorkerPool;
+
+/* Destructive radius range assigned to spawned mines. Also drives spatial grid cell size and k-d tree query bounds */
+const float cMinDestructiveRadius = 100.0f;
+const float cMaxDestructiveRadius = 1000.0f;
+
+/// <summary>
+/// What the targeting pass stores per mine.
+/// </summary>
+enum TargetListMode
+{
+    /* Full target list of every mine */
+    TL_FULL = 0,
+    /* Target count only; lists are built by ResolveExplosion for the mines that explode */
+    TL_COUNT
+};
+
+/// <summary>
+/// How AddMines draws destructive radii, always within [cMinDestructiveRadius, cMaxDestructiveRadius].
+/// Radii set how many mines each query visits and how long target lists get.
+/// </summary>
+enum RadiusDistribution
+{
+    /* Uniform over the whole range */
+    RD_UNIFORM = 0,
+    /* Uniform over the lowest fifth of the range */
+    RD_SMALL,
+    /* Uniform over the highest fifth of the range */
+    RD_LARGE,
+    /* Half small, half large, nothing in between */
+    RD_BIMODAL
+};
+
+/// <summary>
+/// Where and for whom AddMines spawns a mine.
+/// </summary>
+struct MineSpawn
+{
+    unsigned int m_objectId;
+    int m_team;
+    Vector3 m_position;
+};
+
+/// <summary>
+/// Complete description of a mine, as provided by scenario files.
+/// </summary>
+struct MineRecord
+{
+    unsigned int m_objectId;
+    int m_team;
+    Vector3 m_position;
+    float m_destructiveRadius;
+    /* Mine::ObjectBitFlags */
+    unsigned char m_bitFlags;
+};
+
+/// <summary>
+/// Damage a blast dealt to a ghost mine, to be applied by the shard owning it.
+/// </summary>
+struct MineDamage
+{
+    unsigned int m_objectId;
+    float m_damage;
+};
+
+/// <summary>
+/// Fills spawn number aOrdinal of an AddMines batch. Called from several threads at once, in no particular
+/// order, so it must only depend on its arguments (draw from GetCounterRandomUInt32, not from the global generator).
+/// </summary>
+typedef std::function<void(const int aOrdinal, MineSpawn& aSpawn)> MineSpawnGenerator;
 
 class MineManager :
     public ObjectManager<Mine>
 {
 public:
     const Mine* AddMineObject(const unsigned int aObjectId, const Vector3 aPosition, const int aTeam);
+    /// <summary>
+    /// Spawns a batch of mines. Spawns, radii and flags are generated on the worker pool straight into
+    /// storage; only slot bookkeeping and spatial index insertion run sequentially. Like AddMineObject, an
+    /// ID already in use respawns that mine, and the last of several spawns sharing an ID wins. Mines
+    /// land in storage in spawn order and every random value is keyed on the spawn ordinal, so the field
+    /// built only depends on the generator and the seed, never on the number of threads.
+    /// </summary>
+    /// <param name="aCount">int. Number of spawns</param>
+    /// <param name="aGenerator">const MineSpawnGenerator&. Fills each spawn</param>
+    /// <param name="aPool">WorkerPool&. Pool to generate on</param>
+    /// <returns>int. Slot of the first mine added, new mines fill the slots up to the end of storage</returns>
+    int         AddMines(const int aCount, const MineSpawnGenerator& aGenerator, WorkerPool& aPool);
+    /// <summary>
+    /// Adds fully described mines, in order. Like AddMineObject, an ID already in use respawns that mine.
+    /// </summary>
+    /// <param name="aRecords">const MineRecord*. Mines to add</param>
+    /// <param name="aCount">int. Number of records</param>
+    /// <returns>int. Number of mines added, fewer than aCount once the object limit is reached</returns>
+    int         AddMineRecords(const MineRecord* aRecords, const int aCount);
+    /// <summary>
+    /// Draws destructive radius and flags AddMines gives to spawn aOrdinal, for callers building the same
+    /// mines as records.
+    /// </summary>
+    /// <param name="aSeed">unsigned int. Game seed</param>
+    /// <param name="aOrdinal">unsigned int. Spawn ordinal</param>
+    /// <param name="aRadiusDistribution">RadiusDistribution. Range the radius is drawn from</param>
+    /// <param name="aDestructiveRadius">float&. Destructive radius</param>
+    /// <param name="aBitFlags">unsigned char&. Mine::ObjectBitFlags</param>
+    static void DrawSpawnProperties(const unsigned int aSeed, const unsigned int aOrdinal, const RadiusDistribution aRadiusDistribution,
+                                    float& aDestructiveRadius, unsigned char& aBitFlags);
+    /// <summary>
+    /// Replaces every mine with the ones stored in a snapshot. Field arrays are copied section by section
+    /// straight into storage; there is no per mine parsing, only slot bookkeeping and spatial index
+    /// insertion. MineSnapshot::Open has already checked every value.
+    /// </summary>
+    /// <param name="aSnapshot">const MineSnapshot&. Open snapshot</param>
+    void        LoadSnapshot(const MineSnapshot& aSnapshot);
     int         GetNumberOfObjectForTeam(int aTeam);
+    /// <summary>
+    /// Returns team mine with most targets, first in slot order on ties. O(1) lookup into a per team heap.
+    /// </summary>
+    /// <param name="aTeam">int. Team ID</param>
+    /// <returns>Mine*. Mine, NULL if team has none</returns>
     Mine*       GetObjectWithMostEnemyTargets(const int aTeam);
+    /// <summary>
+    /// Explodes mine at aIndex and resolves the whole chain reaction it sets off, breadth first: every
+    /// blast subtracts its damage from the health of the targets still standing, and those reaching zero
+    /// join the end of the queue. Nothing moves while the chain runs; every exploded mine is removed in
+    /// a single batch afterwards. Damage to ghost mines is not applied but queued for TakeRemoteDamage.
+    /// With TL_COUNT, every exploding mine builds its target list when its turn in the queue comes.
+    /// </summary>
+    /// <param name="aIndex">int. Slot of the first mine to explode</param>
+    void        ResolveExplosion(const int aIndex);
+    /// <summary>
+    /// Moves damage dealt to ghost mines since last call into aOut.
+    /// </summary>
+    /// <param name="aOut">std::vector<MineDamage>&. Output list, replaced</param>
+    void        TakeRemoteDamage(std::vector<MineDamage>& aOut);
+    /// <summary>
+    /// Breaks GetObjectWithMostEnemyTargets ties on lowest object ID instead of lowest slot, which does
+    /// not depend on the order mines were removed in. Call before adding mines.
+    /// </summary>
+    /// <param name="aEnabled">bool. Object ID or slot</param>
+    inline void SetObjectIdTieBreak(const bool aEnabled) { m_targetRanking.SetObjectIdTieBreak(aEnabled); }
+    /// <summary>
+    /// Sets seed of the game played on this manager, the key of every counter based draw made for its
+    /// mines. Managers playing side by side each keep their own.
+    /// </summary>
+    /// <param name="aSeed">unsigned int. Game seed</param>
+    inline void SetRandomSeed(const unsigned int aSeed) { m_randomSeed = aSeed; }
+    /// <summary>
+    /// Returns seed of the game played on this manager.
+    /// </summary>
+    /// <returns>unsigned int. Game seed</returns>
+    inline unsigned int GetRandomSeed(void) const { return m_randomSeed; }
+    /// <summary>
+    /// Returns view of the mine a handle was given for, wherever it lives now.
+    /// </summary>
+    /// <param name="aHandle">MineHandle. Handle, as stored in target lists</param>
+    /// <returns>Mine*. Mine, NULL if it was removed since</returns>
+    inline Mine* GetObjectByHandle(const MineHandle aHandle)
+    {
+        const int index(m_storage.Resolve(aHandle));
+
+        return index >= 0 ? &m_views[index] : NULL;
+    }
+    /// <summary>
+    /// Whether pointer refers to a slot currently in use. Storage is compacted on removal, so
+    /// pointers kept across removals may refer to a slot past the last mine.
+    /// </summary>
+    /// <param name="apObject">const Mine*. Pointer to check</param>
+    /// <returns>bool. True if it points to a live slot</returns>
+    bool        Contains(const Mine* apObject) const;
+    /// <summary>
+    /// Appends to aOut the slot index of every mine whose position lies within aRadius of aCenter,
+    /// as reported by the active targeting backend. Safe to call from several threads at once, but
+    /// not while objects are being added or removed.
+    /// </summary>
+    /// <param name="aCenter">Vector3. Query center</param>
+    /// <param name="aRadius">float. Query radius</param>
+    /// <param name="aRejectFlags">unsigned char. Mines having any of these flags set are not reported</param>
+    /// <param name="aOut">std::vector<int>&. Output list, not cleared</param>
+    void        QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const { m_pSpatialIndex->QueryRadius(aCenter, aRadius, aRejectFlags, aOut); }
+    /// <summary>
+    /// Brings targeting backend up to date with last turn removals and works out which mines need their
+    /// target list recomputed. Must be called before every targeting pass.
+    /// </summary>
+    /// <param name="aNumberOfThreads">int. Threads the pass is split across, each gets a target arena buffer</param>
+    void        PrepareTargeting(const int aNumberOfThreads);
+    /// <summary>
+    /// Returns number of targeting passes prepared so far, the current turn.
+    /// </summary>
+    /// <returns>unsigned int. Pass number, 0 before the first one</returns>
+    inline unsigned int GetTargetingPass(void) const { return m_targetingPass; }
+    /// <summary>
+    /// Returns slots whose target list has to be recomputed this turn, in ascending order. Filled by PrepareTargeting.
+    /// </summary>
+    /// <returns>const std::vector<int>&. Slot indexes</returns>
+    inline const std::vector<int>& GetRetargetQueue(void) const { return m_retargetQueue; }
+    /// <summary>
+    /// Enables incremental targeting (default): only mines whose destructive radius reaches a mine added
+    /// or removed since last pass, or an ally whose coin must be thrown again, are retargeted. Otherwise
+    /// every mine is. Both give the same game.
+    /// </summary>
+    /// <param name="aEnabled">bool. Incremental or full</param>
+    inline void SetIncrementalTargeting(const bool aEnabled) { m_incrementalTargeting = aEnabled; }
+    /// <summary>
+    /// Returns if targeting is incremental.
+    /// </summary>
+    /// <returns>bool. True if incremental</returns>
+    inline bool IsIncrementalTargeting(void) const { return m_incrementalTargeting; }
+    /// <summary>
+    /// Selects what targeting passes store. Call before the first one.
+    /// </summary>
+    /// <param name="aMode">TargetListMode. Full lists or counts only</param>
+    inline void SetTargetListMode(const TargetListMode aMode) { m_targetListMode = aMode; }
+    /// <summary>
+    /// Returns what targeting passes store.
+    /// </summary>
+    /// <returns>TargetListMode. Active mode</returns>
+    inline TargetListMode GetTargetListMode(void) const { return m_targetListMode; }
+    /// <summary>
+    /// Returns printable target list mode name.
+    /// </summary>
+    /// <param name="aMode">TargetListMode. Mode</param>
+    /// <returns>const char*. Name, as accepted by ParseTargetListMode</returns>
+    static const char* GetTargetListModeName(const TargetListMode aMode);
+    /// <summary>
+    /// Parses command line name of a target list mode.
+    /// </summary>
+    /// <param name="aName">const char*. full or count</param>
+    /// <param name="aOutMode">TargetListMode&. Parsed mode, untouched on failure</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseTargetListMode(const char* aName, TargetListMode& aOutMode);
+    /// <summary>
+    /// Selects how AddMines draws destructive radii. Call before spawning.
+    /// </summary>
+    /// <param name="aDistribution">RadiusDistribution. Radius distribution</param>
+    inline void SetRadiusDistribution(const RadiusDistribution aDistribution) { m_radiusDistribution = aDistribution; }
+    /// <summary>
+    /// Returns how AddMines draws destructive radii.
+    /// </summary>
+    /// <returns>RadiusDistribution. Active distribution</returns>
+    inline RadiusDistribution GetRadiusDistribution(void) const { return m_radiusDistribution; }
+    /// <summary>
+    /// Returns printable radius distribution name.
+    /// </summary>
+    /// <param name="aDistribution">RadiusDistribution. Distribution</param>
+    /// <returns>const char*. Name, as accepted by ParseRadiusDistribution</returns>
+    static const char* GetRadiusDistributionName(const RadiusDistribution aDistribution);
+    /// <summary>
+    /// Parses command line name of a radius distribution.
+    /// </summary>
+    /// <param name="aName">const char*. uniform, small, large or bimodal</param>
+    /// <param name="aOutDistribution">RadiusDistribution&. Parsed distribution, untouched on failure</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseRadiusDistribution(const char* aName, RadiusDistribution& aOutDistribution);
+    /// <summary>
+    /// Selects structure used to answer targeting queries. Existing objects are moved into the new one.
+    /// </summary>
+    /// <param name="aBackend">TargetingBackend. Backend to use</param>
+    void        SetTargetingBackend(const TargetingBackend aBackend);
+    /// <summary>
+    /// Returns structure used to answer targeting queries.
+    /// </summary>
+    /// <returns>TargetingBackend. Active backend</returns>
+    inline TargetingBackend GetTargetingBackend(void) const { return m_targetingBackend; }
+    /// <summary>
+    /// Returns mine field arrays, for loops that want to stream them directly.
+    /// </summary>
+    /// <returns>const MineStorage&. Storage</returns>
+    inline const MineStorage& GetStorage(void) const { return m_storage; }
+    /// <summary>
+    /// Returns arena target lists are built in.
+    /// </summary>
+    /// <returns>TargetArena&. Arena, see MineStorage::m_targetSpan</returns>
+    inline TargetArena& GetTargetArena(void) { return m_targetArena; }
     
+    /// <summary>
+    /// Returns manager of the game run from the command line. Games played side by side use managers of their own.
+    /// </summary>
+    /// <returns>MineManager&. Shared manager</returns>
     static MineManager& GetInstance(void) {
         static MineManager instance;
         return instance;
     }
 
+    MineManager(void);
+    ~MineManager(void);
+
     /* Overrided functions */
+    virtual void  Init(const int aPools, const int aObjectPerPool) override;
     virtual void  AddObject(const Mine* apObject) override;
     virtual void  AddObject(const int objectId, const int poolID) override;
     virtual void  RemoveObject(const Mine* apObject) override;
@@ -27,8 +308,56 @@ public:
     virtual Mine* GetObjectByIndex(const int aIndex) override;
     virtual void  Dispose(void) override;
 
-protected:
-    MineManager(void);
-    ~MineManager(void);
+private:
+    /// <summary>
+    /// Appends a mine with default values to storage and ranks it in its team heap, without registering
+    /// it into the spatial index.
+    /// </summary>
+    /// <param name="aObjectId">unsigned int. Object ID</param>
+    /// <param name="aTeam">int. Team ID</param>
+    /// <returns>int. Slot index</returns>
+    int           AllocateSlot(const unsigned int aObjectId, const int aTeam);
+    /// <summary>
+    /// Removes mine at aIndex by moving last mine into its slot, keeping spatial index up to date.
+    /// </summary>
+    /// <param name="aIndex">int. Slot index</param>
+    void          EraseSlot(const int aIndex);
+    /// <summary>
+    /// Re-inserts every object into the spatial index.
+    /// </summary>
+    void          RebuildSpatialIndex(void);
+    /// <summary>
+    /// Re-sorts mines retargeted in last targeting pass inside the ranking, if not done yet.
+    /// </summary>
+    void          FlushTargetRanking(void);
+
+    MineStorage m_storage;
+    /* One view per slot ever used. deque keeps their address stable while growing */
+    std::deque<Mine> m_views;
+    std::unordered_map<int, int> m_numberOfObjectsPerTeam;
+    /* Object ID to storage slot. AddMineObject keeps IDs unique by respawning duplicates */
+    std::unordered_map<unsigned int, int> m_slotOfObjectId;
+    std::unique_ptr<SpatialIndex> m_pSpatialIndex;
+    TargetingBackend m_targetingBackend;
+    /* Positions of mines added or removed since last targeting pass. Target lists of mines reaching
+    any of them may hold a stale or missing entry */
+    std::vector<Vector3> m_changedPositions;
+    std::vector<int> m_retargetQueue;
+    /* PrepareTargeting scratch: per slot "already queued" marks and query results */
+    std::vector<unsigned char> m_queued;
+    std::vector<int> m_candidates;
+    /* ResolveExplosion scratch: slots that exploded, in blast order */
+    std::vector<int> m_explosionQueue;
+    /* Damage dealt to ghosts, waiting to be sent to their owner */
+    std::vector<MineDamage> m_remoteDamage;
+    bool m_incrementalTargeting;
+    TargetListMode m_targetListMode;
+    RadiusDistribution m_radiusDistribution;
+    unsigned int m_targetingPass;
+    unsigned int m_randomSeed;
+    TargetRanking m_targetRanking;
+    /* Set by PrepareTargeting: target lists of the retarget queue are about to change */
+    bool m_targetRankingStale;
+    TargetArena m_targetArena;
 };
 
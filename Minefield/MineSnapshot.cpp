@@ -0,0 +1,357 @@
+#include "stdafx.h"
+#include "MineSnapshot.h"
+#include "MineManager.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#ifdef __linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char cMagic[8] = { 'M', 'I', 'N', 'E', 'S', 'N', 'A', 'P' };
+
+    /// <summary>
+    /// On disk header, at offset 0. Section offsets are from the start of the file.
+    /// </summary>
+    struct SnapshotHeader
+    {
+        char     m_magic[8];
+        uint32_t m_version;
+        uint32_t m_headerSize;
+        uint32_t m_numberOfMines;
+        int32_t  m_numberOfTeams;
+        uint64_t m_fileSize;
+        uint64_t m_sectionOffset[SS_COUNT];
+    };
+
+    /* Element size of every section, matching the MineStorage arrays */
+    const size_t cSectionElementSize[SS_COUNT] =
+    {
+        sizeof(unsigned int), sizeof(int), sizeof(float), sizeof(float), sizeof(float),
+        sizeof(float), sizeof(float), sizeof(float), sizeof(unsigned char)
+    };
+
+    inline uint64_t Align(const uint64_t aOffset)
+    {
+        return (aOffset + MineSnapshot::cAlignment - 1) / MineSnapshot::cAlignment * MineSnapshot::cAlignment;
+    }
+
+    const void* GetStorageSection(const MineStorage& aStorage, const SnapshotSection aSection)
+    {
+        switch (aSection)
+        {
+        case SS_OBJECT_ID:
+            return aStorage.m_objectId.data();
+        case SS_TEAM:
+            return aStorage.m_team.data();
+        case SS_POSITION_X:
+            return aStorage.m_positionX.data();
+        case SS_POSITION_Y:
+            return aStorage.m_positionY.data();
+        case SS_POSITION_Z:
+            return aStorage.m_positionZ.data();
+        case SS_DESTRUCTIVE_RADIUS:
+            return aStorage.m_destructiveRadius.data();
+        case SS_HEALTH:
+            return aStorage.m_health.data();
+        case SS_EXPLOSIVE_YIELD:
+            return aStorage.m_explosiveYield.data();
+        case SS_BIT_FLAGS:
+            return aStorage.m_bitFlags.data();
+        default:
+            return NULL;
+        }
+    }
+}
+
+MineSnapshot::MineSnapshot() :
+    m_pData(NULL)
+  , m_size(0)
+  , m_numberOfMines(0)
+  , m_numberOfTeams(0)
+#ifdef _WIN32
+  , m_file(INVALID_HANDLE_VALUE)
+  , m_mapping(NULL)
+#endif
+{
+    memset(m_sectionOffset, 0, sizeof(m_sectionOffset));
+}
+
+MineSnapshot::~MineSnapshot()
+{
+    Close();
+}
+
+SnapshotResult MineSnapshot::Save(const char* aPath, const MineStorage& aStorage, const int aNumberOfTeams)
+{
+    const uint64_t numberOfMines(static_cast<uint64_t>(aStorage.GetSize()));
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, cMagic, sizeof(cMagic));
+    header.m_version = cVersion;
+    header.m_headerSize = sizeof(SnapshotHeader);
+    header.m_numberOfMines = static_cast<uint32_t>(numberOfMines);
+    header.m_numberOfTeams = aNumberOfTeams;
+
+    uint64_t offset(Align(sizeof(SnapshotHeader)));
+
+    for (int section = 0; section < SS_COUNT; ++section)
+    {
+        header.m_sectionOffset[section] = offset;
+        offset = Align(offset + numberOfMines * cSectionElementSize[section]);
+    }
+
+    header.m_fileSize = offset;
+
+    FILE* pFile(fopen(aPath, "wb"));
+
+    if (NULL == pFile)
+    {
+        return SR_CANNOT_OPEN;
+    }
+
+    static const char cPadding[cAlignment] = { 0 };
+    bool written(1 == fwrite(&header, sizeof(header), 1, pFile));
+    uint64_t position(sizeof(header));
+
+    for (int section = 0; written && section < SS_COUNT; ++section)
+    {
+        const size_t size(static_cast<size_t>(numberOfMines * cSectionElementSize[section]));
+
+        written = fwrite(cPadding, 1, static_cast<size_t>(header.m_sectionOffset[section] - position), pFile) == header.m_sectionOffset[section] - position &&
+                  (0 == size || fwrite(GetStorageSection(aStorage, static_cast<SnapshotSection>(section)), 1, size, pFile) == size);
+        position = header.m_sectionOffset[section] + size;
+    }
+
+    written = written && fwrite(cPadding, 1, static_cast<size_t>(header.m_fileSize - position), pFile) == header.m_fileSize - position;
+    written = 0 == fclose(pFile) && written;
+
+    return written ? SR_OK : SR_CANNOT_WRITE;
+}
+
+const char* MineSnapshot::GetResultName(const SnapshotResult aResult)
+{
+    switch (aResult)
+    {
+    case SR_OK:
+        return "ok";
+    case SR_CANNOT_OPEN:
+        return "cannot open file";
+    case SR_CANNOT_WRITE:
+        return "cannot write file";
+    case SR_BAD_FORMAT:
+        return "not a minefield snapshot";
+    case SR_UNSUPPORTED_VERSION:
+        return "unsupported snapshot version";
+    case SR_TRUNCATED:
+        return "snapshot is truncated";
+    case SR_TOO_MANY_MINES:
+        return "too many mines";
+    }
+
+    return "unknown";
+}
+
+SnapshotResult MineSnapshot::Open(const char* aPath)
+{
+    Close();
+
+#ifdef _WIN32
+    m_file = CreateFileA(aPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    LARGE_INTEGER fileSize;
+
+    if (INVALID_HANDLE_VALUE == m_file || !GetFileSizeEx(m_file, &fileSize))
+    {
+        Close();
+        return SR_CANNOT_OPEN;
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    if (m_size >= sizeof(SnapshotHeader))
+    {
+        m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        m_pData = NULL != m_mapping ? static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : NULL;
+
+        if (NULL == m_pData)
+        {
+            Close();
+            return SR_CANNOT_OPEN;
+        }
+    }
+#elif __linux
+    const int file(open(aPath, O_RDONLY));
+    struct stat status;
+
+    if (file < 0 || 0 != fstat(file, &status))
+    {
+        if (file >= 0)
+        {
+            close(file);
+        }
+
+        return SR_CANNOT_OPEN;
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+
+    if (m_size >= sizeof(SnapshotHeader))
+    {
+        void* pMapping(mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, file, 0));
+
+        if (MAP_FAILED == pMapping)
+        {
+            close(file);
+            m_size = 0;
+            return SR_CANNOT_OPEN;
+        }
+
+        /* Sections are read front to back once, on load */
+        madvise(pMapping, m_size, MADV_SEQUENTIAL);
+        m_pData = static_cast<const unsigned char*>(pMapping);
+    }
+
+    /* Mapping keeps its own reference to the file */
+    close(file);
+#endif
+
+    if (NULL == m_pData)
+    {
+        Close();
+        return SR_BAD_FORMAT;
+    }
+
+    const SnapshotHeader& header(*reinterpret_cast<const SnapshotHeader*>(m_pData));
+    SnapshotResult result(SR_OK);
+
+    if (0 != memcmp(header.m_magic, cMagic, sizeof(cMagic)))
+    {
+        result = SR_BAD_FORMAT;
+    }
+    else if (cVersion != header.m_version)
+    {
+        result = SR_UNSUPPORTED_VERSION;
+    }
+    else if (sizeof(SnapshotHeader) != header.m_headerSize || header.m_numberOfTeams < 0)
+    {
+        result = SR_BAD_FORMAT;
+    }
+    else if (header.m_fileSize > m_size)
+    {
+        result = SR_TRUNCATED;
+    }
+    else if (header.m_numberOfMines > static_cast<uint32_t>(cMaximumNumberOfObjects))
+    {
+        result = SR_TOO_MANY_MINES;
+    }
+
+    for (int section = 0; SR_OK == result && section < SS_COUNT; ++section)
+    {
+        const uint64_t offset(header.m_sectionOffset[section]);
+
+        if (0 != offset % cAlignment || offset < sizeof(SnapshotHeader))
+        {
+            result = SR_BAD_FORMAT;
+        }
+        else if (offset > header.m_fileSize || header.m_fileSize - offset < header.m_numberOfMines * cSectionElementSize[section])
+        {
+            result = SR_TRUNCATED;
+        }
+
+        m_sectionOffset[section] = offset;
+    }
+
+    if (SR_OK != result)
+    {
+        Close();
+        return result;
+    }
+
+    m_numberOfMines = static_cast<int>(header.m_numberOfMines);
+    m_numberOfTeams = header.m_numberOfTeams;
+
+    /* Loading indexes per team arrays with these values and maps IDs one to one, never trust them */
+    if (!ValidateMines())
+    {
+        Close();
+        return SR_BAD_FORMAT;
+    }
+
+    return SR_OK;
+}
+
+bool MineSnapshot::ValidateMines(void) const
+{
+    const int* pTeam(static_cast<const int*>(GetSection(SS_TEAM)));
+    const float* pX(static_cast<const float*>(GetSection(SS_POSITION_X)));
+    const float* pY(static_cast<const float*>(GetSection(SS_POSITION_Y)));
+    const float* pZ(static_cast<const float*>(GetSection(SS_POSITION_Z)));
+    const float* pRadius(static_cast<const float*>(GetSection(SS_DESTRUCTIVE_RADIUS)));
+    const float* pHealth(static_cast<const float*>(GetSection(SS_HEALTH)));
+    const float* pExplosiveYield(static_cast<const float*>(GetSection(SS_EXPLOSIVE_YIELD)));
+    const unsigned char* pBitFlags(static_cast<const unsigned char*>(GetSection(SS_BIT_FLAGS)));
+    /* Snapshots are saved before the first turn, when no other flag can be set yet */
+    const unsigned char savedFlags(Mine::OBF_ACTIVE | Mine::OBF_INVULNERABLE);
+
+    for (int i = 0; i < m_numberOfMines; ++i)
+    {
+        if (pTeam[i] < 0 || pTeam[i] >= m_numberOfTeams ||
+            !std::isfinite(pX[i]) || !std::isfinite(pY[i]) || !std::isfinite(pZ[i]) ||
+            !(pRadius[i] >= cMinDestructiveRadius && pRadius[i] <= cMaxDestructiveRadius) ||
+            !(std::isfinite(pHealth[i]) && pHealth[i] > 0.0f) ||
+            !(std::isfinite(pExplosiveYield[i]) && pExplosiveYield[i] >= 0.0f) ||
+            0 != (pBitFlags[i] & ~savedFlags))
+        {
+            return false;
+        }
+    }
+
+    /* Sorted copy, cheaper than a hash set for a one off check */
+    const unsigned int* pObjectId(static_cast<const unsigned int*>(GetSection(SS_OBJECT_ID)));
+    std::vector<unsigned int> objectIds(pObjectId, pObjectId + m_numberOfMines);
+
+    std::sort(objectIds.begin(), objectIds.end());
+
+    return std::end(objectIds) == std::adjacent_find(objectIds.begin(), objectIds.end());
+}
+
+void MineSnapshot::Close(void)
+{
+#ifdef _WIN32
+    if (NULL != m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+    }
+    if (NULL != m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+    if (INVALID_HANDLE_VALUE != m_file)
+    {
+        CloseHandle(m_file);
+    }
+
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#elif __linux
+    if (NULL != m_pData)
+    {
+        munmap(const_cast<unsigned char*>(m_pData), m_size);
+    }
+#endif
+
+    m_pData = NULL;
+    m_size = 0;
+    m_numberOfMines = 0;
+    m_numberOfTeams = 0;
+    memset(m_sectionOffset, 0, sizeof(m_sectionOffset));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "MineStorage.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include "Windows.h"
+#endif
+
+/// <summary>
+/// Outcome of snapshot operations.
+/// </summary>
+enum SnapshotResult
+{
+    SR_OK = 0,
+    SR_CANNOT_OPEN,
+    SR_CANNOT_WRITE,
+    SR_BAD_FORMAT,
+    SR_UNSUPPORTED_VERSION,
+    SR_TRUNCATED,
+    SR_TOO_MANY_MINES
+};
+
+/// <summary>
+/// Field arrays stored in a snapshot, one section each.
+/// </summary>
+enum SnapshotSection
+{
+    SS_OBJECT_ID = 0,
+    SS_TEAM,
+    SS_POSITION_X,
+    SS_POSITION_Y,
+    SS_POSITION_Z,
+    SS_DESTRUCTIVE_RADIUS,
+    SS_HEALTH,
+    SS_EXPLOSIVE_YIELD,
+    SS_BIT_FLAGS,
+    SS_COUNT
+};
+
+/// <summary>
+/// Binary minefield snapshot: a fixed header followed by one section per MineStorage field array, each
+/// a raw little endian array starting on a cSnapshotAlignment boundary. A snapshot is read by mapping
+/// the file into memory, sections are used in place, so opening one costs the same for ten mines or
+/// ten million. Target lists are not stored, the first targeting pass rebuilds them.
+/// </summary>
+class MineSnapshot
+{
+public:
+    static const uint32_t cVersion = 1;
+    static const size_t cAlignment = 64;
+
+    MineSnapshot(void);
+    ~MineSnapshot(void);
+
+    MineSnapshot(const MineSnapshot&) = delete;
+    MineSnapshot& operator=(const MineSnapshot&) = delete;
+
+    /// <summary>
+    /// Writes every mine in storage to a snapshot file, replacing it.
+    /// </summary>
+    /// <param name="aPath">const char*. File path</param>
+    /// <param name="aStorage">const MineStorage&. Mines to save</param>
+    /// <param name="aNumberOfTeams">int. Number of teams of the scenario</param>
+    /// <returns>SnapshotResult. SR_OK or the reason it failed</returns>
+    static SnapshotResult Save(const char* aPath, const MineStorage& aStorage, const int aNumberOfTeams);
+    /// <summary>
+    /// Returns printable description of a result.
+    /// </summary>
+    /// <param name="aResult">SnapshotResult. Result</param>
+    /// <returns>const char*. Description</returns>
+    static const char* GetResultName(const SnapshotResult aResult);
+
+    /// <summary>
+    /// Maps a snapshot file and validates its header, section bounds and mines: teams in range, unique
+    /// object IDs, finite positions and radii within [cMinDestructiveRadius, cMaxDestructiveRadius], as
+    /// ScenarioReader requires of its records, plus finite positive health, finite non negative explosive
+    /// yield and no flags but active and invulnerable. Closes any snapshot open before.
+    /// </summary>
+    /// <param name="aPath">const char*. File path</param>
+    /// <returns>SnapshotResult. SR_OK or the reason it cannot be used</returns>
+    SnapshotResult Open(const char* aPath);
+    /// <summary>
+    /// Unmaps the file. Section pointers are invalid afterwards.
+    /// </summary>
+    void           Close(void);
+
+    /// <summary>
+    /// Returns number of mines stored.
+    /// </summary>
+    /// <returns>int. Number of mines, 0 if nothing is open</returns>
+    inline int GetNumberOfMines(void) const { return m_numberOfMines; }
+    /// <summary>
+    /// Returns number of teams of the scenario.
+    /// </summary>
+    /// <returns>int. Number of teams</returns>
+    inline int GetNumberOfTeams(void) const { return m_numberOfTeams; }
+    /// <summary>
+    /// Returns start of a section inside the mapped file, GetNumberOfMines() elements long. Element type
+    /// is that of the matching MineStorage array.
+    /// </summary>
+    /// <param name="aSection">SnapshotSection. Section</param>
+    /// <returns>const void*. Section data, NULL if nothing is open</returns>
+    inline const void* GetSection(const SnapshotSection aSection) const { return NULL != m_pData ? m_pData + m_sectionOffset[aSection] : NULL; }
+
+private:
+    /// <summary>
+    /// Checks every mine of the open snapshot can be loaded as is.
+    /// </summary>
+    /// <returns>bool. False if a team is out of range, an object ID is used twice or a value is unusable</returns>
+    bool ValidateMines(void) const;
+
+    const unsigned char* m_pData;
+    size_t m_size;
+    int m_numberOfMines;
+    int m_numberOfTeams;
+    uint64_t m_sectionOffset[SS_COUNT];
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
@@ -0,0 +1,196 @@
+#include "stdafx.h"
+#include "MineStorage.h"
+#include <assert.h>
+
+MineStorage::MineStorage() :
+    m_handleClock(0)
+{
+}
+
+MineStorage::~MineStorage()
+{
+}
+
+void MineStorage::Reserve(const int aCapacity)
+{
+    m_positionX.reserve(aCapacity);
+    m_positionY.reserve(aCapacity);
+    m_positionZ.reserve(aCapacity);
+    m_destructiveRadius.reserve(aCapacity);
+    m_health.reserve(aCapacity);
+    m_explosiveYield.reserve(aCapacity);
+    m_bitFlags.reserve(aCapacity);
+    m_team.reserve(aCapacity);
+    m_objectId.reserve(aCapacity);
+    m_handle.reserve(aCapacity);
+    m_numberOfTargets.reserve(aCapacity);
+    m_targetPass.reserve(aCapacity);
+    m_allyInRange.reserve(aCapacity);
+    m_targetSpan.reserve(aCapacity);
+    m_handleSlot.reserve(aCapacity);
+    m_handleGeneration.reserve(aCapacity);
+    m_handleAcquired.reserve(aCapacity);
+}
+
+int MineStorage::Add(const unsigned int aObjectId, const int aTeam)
+{
+    const int index(GetSize());
+
+    m_positionX.push_back(0.0f);
+    m_positionY.push_back(0.0f);
+    m_positionZ.push_back(0.0f);
+    m_destructiveRadius.push_back(0.0f);
+    m_health.push_back(100.0f);
+    m_explosiveYield.push_back(500.0f);
+    m_bitFlags.push_back(0);
+    m_team.push_back(aTeam);
+    m_objectId.push_back(aObjectId);
+    m_handle.push_back(AcquireHandle(index));
+    m_numberOfTargets.push_back(0);
+    m_targetPass.push_back(0);
+    m_allyInRange.push_back(0);
+    m_targetSpan.push_back({ 0, 0, 0, TE_HANDLES });
+
+    return index;
+}
+
+int MineStorage::AddRange(const int aCount)
+{
+    const int first(GetSize());
+    const size_t size(static_cast<size_t>(first + aCount));
+
+    m_positionX.resize(size, 0.0f);
+    m_positionY.resize(size, 0.0f);
+    m_positionZ.resize(size, 0.0f);
+    m_destructiveRadius.resize(size, 0.0f);
+    m_health.resize(size, 100.0f);
+    m_explosiveYield.resize(size, 500.0f);
+    m_bitFlags.resize(size, 0);
+    m_team.resize(size, -1);
+    m_objectId.resize(size, 0);
+    m_numberOfTargets.resize(size, 0);
+    m_targetPass.resize(size, 0);
+    m_allyInRange.resize(size, 0);
+    m_targetSpan.resize(size, { 0, 0, 0, TE_HANDLES });
+
+    for (int index = first; index < first + aCount; ++index)
+    {
+        m_handle.push_back(AcquireHandle(index));
+    }
+
+    return first;
+}
+
+void MineStorage::Remove(const int aIndex)
+{
+    const int last(GetSize() - 1);
+
+    if (aIndex < 0 || aIndex > last)
+    {
+        return;
+    }
+
+    ReleaseHandle(m_handle[aIndex]);
+
+    if (aIndex != last)
+    {
+        m_positionX[aIndex] = m_positionX[last];
+        m_positionY[aIndex] = m_positionY[last];
+        m_positionZ[aIndex] = m_positionZ[last];
+        m_destructiveRadius[aIndex] = m_destructiveRadius[last];
+        m_health[aIndex] = m_health[last];
+        m_explosiveYield[aIndex] = m_explosiveYield[last];
+        m_bitFlags[aIndex] = m_bitFlags[last];
+        m_team[aIndex] = m_team[last];
+        m_objectId[aIndex] = m_objectId[last];
+        m_handle[aIndex] = m_handle[last];
+        m_handleSlot[m_handle[aIndex] & cMineHandleIndexMask] = aIndex;
+        m_numberOfTargets[aIndex] = m_numberOfTargets[last];
+        m_targetPass[aIndex] = m_targetPass[last];
+        m_allyInRange[aIndex] = m_allyInRange[last];
+        m_targetSpan[aIndex] = m_targetSpan[last];
+    }
+
+    m_positionX.pop_back();
+    m_positionY.pop_back();
+    m_positionZ.pop_back();
+    m_destructiveRadius.pop_back();
+    m_health.pop_back();
+    m_explosiveYield.pop_back();
+    m_bitFlags.pop_back();
+    m_team.pop_back();
+    m_objectId.pop_back();
+    m_handle.pop_back();
+    m_numberOfTargets.pop_back();
+    m_targetPass.pop_back();
+    m_allyInRange.pop_back();
+    m_targetSpan.pop_back();
+}
+
+void MineStorage::Clear(void)
+{
+    m_positionX.clear();
+    m_positionY.clear();
+    m_positionZ.clear();
+    m_destructiveRadius.clear();
+    m_health.clear();
+    m_explosiveYield.clear();
+    m_bitFlags.clear();
+    m_team.clear();
+    m_objectId.clear();
+    m_handle.clear();
+    m_numberOfTargets.clear();
+    m_targetPass.clear();
+    m_allyInRange.clear();
+    m_targetSpan.clear();
+
+    /* No handle is live any more: entries retired on reaching the last generation come back, instead of the
+    table growing by one game worth of entries every few thousand games played on this storage */
+    m_handleSlot.clear();
+    m_handleGeneration.clear();
+    m_handleAcquired.clear();
+    m_freeHandleEntries.clear();
+    m_handleClock = 0;
+}
+
+MineHandle MineStorage::AcquireHandle(const int aIndex)
+{
+    unsigned int entry;
+
+    if (!m_freeHandleEntries.empty())
+    {
+        entry = m_freeHandleEntries.back();
+        m_freeHandleEntries.pop_back();
+    }
+    else
+    {
+        entry = static_cast<unsigned int>(m_handleSlot.size());
+
+        /* Entry bits would spill into the generation, and the last entry is cInvalidMineHandle's. Live mines
+        stay below it, only billions of retired entries between two Clear calls could get there */
+        assert(entry < cMineHandleIndexMask);
+
+        m_handleSlot.push_back(-1);
+        m_handleGeneration.push_back(0);
+        m_handleAcquired.push_back(0);
+    }
+
+    m_handleSlot[entry] = aIndex;
+    m_handleAcquired[entry] = m_handleClock++;
+
+    return (m_handleGeneration[entry] << cMineHandleIndexBits) | entry;
+}
+
+void MineStorage::ReleaseHandle(const MineHandle aHandle)
+{
+    const unsigned int entry(aHandle & cMineHandleIndexMask);
+
+    m_handleSlot[entry] = -1;
+
+    /* A wrapped generation would let the oldest stale handles resolve again */
+    if (m_handleGeneration[entry] < cMineHandleMaxGeneration)
+    {
+        m_handleGeneration[entry]++;
+        m_freeHandleEntries.push_back(entry);
+    }
+}
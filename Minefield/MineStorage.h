@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Object.h"
+#include <vector>
+
+class Mine;
+
+/* Generational mine handle. Low cMineHandleIndexBits bits pick a handle table entry, the rest count how
+many times that entry has been reused, so a handle kept after its mine was removed never resolves to
+whichever mine got the entry next. Unlike a slot index it survives the mine being moved to another slot */
+typedef unsigned int MineHandle;
+
+const int cMineHandleIndexBits = 20;
+const unsigned int cMineHandleIndexMask = (1u << cMineHandleIndexBits) - 1;
+const unsigned int cMineHandleMaxGeneration = 0xFFFFFFFFu >> cMineHandleIndexBits;
+/* Never handed out: its table entry lies beyond any capacity allowed */
+const MineHandle cInvalidMineHandle = 0xFFFFFFFFu;
+
+/// <summary>
+/// How a target list is laid out in the TargetArena.
+/// </summary>
+enum TargetEncoding
+{
+    /* One MineHandle per target */
+    TE_HANDLES = 0,
+    /* Dense lists: cTargetBitsetHeaderSize entries, then one bit per handle table entry from the first word on */
+    TE_BITSET
+};
+
+/* Bitset entries ahead of the bits: index of the first word, handle clock the list was built at */
+const unsigned int cTargetBitsetHeaderSize = 2;
+
+/// <summary>
+/// Where a target list lives in the TargetArena: m_count entries of buffer m_buffer from m_offset on.
+/// </summary>
+struct TargetSpan
+{
+    unsigned int m_buffer;
+    unsigned int m_offset;
+    unsigned int m_count;
+    TargetEncoding m_encoding;
+};
+
+/// <summary>
+/// Structure-of-arrays mine storage. Every field lives in its own contiguous array indexed by a dense
+/// slot index, so hot loops (targeting, explosion) only stream the fields they actually read instead
+/// of whole mine objects. Slots are always packed in [0, GetSize()): removal moves the last mine into
+/// the freed slot.
+/// Every mine also owns a MineHandle, resolved through a table that follows the mine across slots.
+/// Handle table entries are recycled through a free list, with their generation bumped on release, and
+/// the whole table is reset by Clear, so it never outgrows the most mines held at once by much.
+/// </summary>
+struct MineStorage
+{
+    MineStorage(void);
+    ~MineStorage(void);
+
+    /// <summary>
+    /// Preallocates every field array.
+    /// </summary>
+    /// <param name="aCapacity">int. Number of mines</param>
+    void Reserve(const int aCapacity);
+    /// <summary>
+    /// Appends a mine with default field values.
+    /// </summary>
+    /// <param name="aObjectId">unsigned int. Object ID</param>
+    /// <param name="aTeam">int. Team ID</param>
+    /// <returns>int. Slot index of the new mine</returns>
+    int  Add(const unsigned int aObjectId, const int aTeam);
+    /// <summary>
+    /// Appends aCount mines with default field values and no team, for callers filling the arrays in bulk.
+    /// </summary>
+    /// <param name="aCount">int. Number of mines</param>
+    /// <returns>int. Slot index of the first new mine</returns>
+    int  AddRange(const int aCount);
+    /// <summary>
+    /// Removes mine at aIndex. Last mine is moved into the freed slot, its handle keeps resolving to it.
+    /// </summary>
+    /// <param name="aIndex">int. Slot index</param>
+    void Remove(const int aIndex);
+    /// <summary>
+    /// Removes all mines, keeping allocated memory. The handle table starts over, so handles given so far
+    /// must be dropped: they may resolve to mines added later.
+    /// </summary>
+    void Clear(void);
+
+    /// <summary>
+    /// Returns number of mines stored.
+    /// </summary>
+    /// <returns>int. Number of used slots</returns>
+    inline int     GetSize(void) const { return static_cast<int>(m_objectId.size()); }
+    /// <summary>
+    /// Returns mine position.
+    /// </summary>
+    /// <param name="aIndex">int. Slot index</param>
+    /// <returns>Vector3. Position</returns>
+    inline Vector3 GetPosition(const int aIndex) const { return Vector3(m_positionX[aIndex], m_positionY[aIndex], m_positionZ[aIndex]); }
+    /// <summary>
+    /// Sets mine position.
+    /// </summary>
+    /// <param name="aIndex">int. Slot index</param>
+    /// <param name="aPosition">Vector3. New position</param>
+    inline void    SetPosition(const int aIndex, const Vector3& aPosition) { m_positionX[aIndex] = aPosition.x; m_positionY[aIndex] = aPosition.y; m_positionZ[aIndex] = aPosition.z; }
+    /// <summary>
+    /// Returns slot currently holding the mine a handle was given for.
+    /// </summary>
+    /// <param name="aHandle">MineHandle. Handle to resolve</param>
+    /// <returns>int. Slot index, -1 if the mine was removed</returns>
+    inline int     Resolve(const MineHandle aHandle) const
+    {
+        const unsigned int entry(aHandle & cMineHandleIndexMask);
+
+        return entry < m_handleGeneration.size() && m_handleGeneration[entry] == (aHandle >> cMineHandleIndexBits) ? m_handleSlot[entry] : -1;
+    }
+    /// <summary>
+    /// Returns slot of the mine holding a handle table entry, provided it got the entry before the
+    /// handle clock read aClock. Same answer as Resolve on the handle the entry had back then.
+    /// </summary>
+    /// <param name="aEntry">unsigned int. Handle table entry, of a handle this storage gave</param>
+    /// <param name="aClock">unsigned int. GetHandleClock() when the entry was recorded</param>
+    /// <returns>int. Slot index, -1 if the mine was removed</returns>
+    inline int     ResolveEntry(const unsigned int aEntry, const unsigned int aClock) const { return m_handleAcquired[aEntry] < aClock ? m_handleSlot[aEntry] : -1; }
+    /// <summary>
+    /// Returns number of handles handed out since the storage was last cleared.
+    /// </summary>
+    /// <returns>unsigned int. Handle clock</returns>
+    inline unsigned int GetHandleClock(void) const { return m_handleClock; }
+
+    /* Field arrays, read directly by hot loops. All of them have GetSize() elements */
+    std::vector<float>              m_positionX;
+    std::vector<float>              m_positionY;
+    std::vector<float>              m_positionZ;
+    std::vector<float>              m_destructiveRadius;
+    std::vector<float>              m_health;
+    std::vector<float>              m_explosiveYield;
+    std::vector<unsigned char>      m_bitFlags;
+    std::vector<int>                m_team;
+    std::vector<unsigned int>       m_objectId;
+    std::vector<MineHandle>         m_handle;
+    /* Size of the target list as of the last targeting pass, kept even when the list itself is not built */
+    std::vector<int>                m_numberOfTargets;
+    /* Targeting pass the mine was last targeted in, 0 if never */
+    std::vector<unsigned int>       m_targetPass;
+    /* Set if an ally lay within destructive radius on the last targeting pass: its coin is thrown anew every pass */
+    std::vector<unsigned char>      m_allyInRange;
+    /* Target list, empty when not built. May be shorter than m_numberOfTargets once lazily built */
+    std::vector<TargetSpan>         m_targetSpan;
+
+private:
+    /// <summary>
+    /// Takes a handle table entry, from the free list if possible, pointing it at aIndex.
+    /// </summary>
+    /// <param name="aIndex">int. Slot index</param>
+    /// <returns>MineHandle. New handle</returns>
+    MineHandle AcquireHandle(const int aIndex);
+    /// <summary>
+    /// Makes a handle stale and recycles its entry. Entries whose generation ran out are retired instead.
+    /// </summary>
+    /// <param name="aHandle">MineHandle. Handle to release</param>
+    void       ReleaseHandle(const MineHandle aHandle);
+
+    /* Handle table, indexed by entry: slot of the owning mine (-1 if free), current generation and
+    handle clock when last acquired */
+    std::vector<int>          m_handleSlot;
+    std::vector<unsigned int> m_handleGeneration;
+    std::vector<unsigned int> m_handleAcquired;
+    unsigned int              m_handleClock;
+    std::vector<unsigned int> m_freeHandleEntries;
+};
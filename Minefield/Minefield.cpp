@@ -48,15 +48,24 @@
 #include "stdafx.h"
 #ifdef _WIN32
 #include "Windows.h"
-#include <process.h>
 #endif
 #include "MineManager.h"
 #include "Mine.h"
+#include "MineSnapshot.h"
+#include "ScenarioReader.h"
+#include "ShardedSimulation.h"
+#include "Simulation.h"
+#include "BatchRunner.h"
+#include "DistanceKernel.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+#include "WorkerPool.h"
+#include <string.h>
 #ifdef __linux
 #include <time.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <pthread.h>
 #include <stdio.h>
 #include "Minefield.h"
 #endif
@@ -64,306 +73,535 @@
 int g_numberOfTeams = 5;
 int g_numberOfMinesPerTeam = 1500;
 bool g_useHashIDs = false;
+SpawnDistribution g_spawnDistribution = SD_UNIFORM;
 
-#ifdef _WIN32
-class QueryPerformanceTimer
+namespace
 {
-public:
-    QueryPerformanceTimer()
+    /// <summary>
+    /// Returns value of a "--aName=value" command line option, NULL if aArg is a different option.
+    /// </summary>
+    const char* GetOptionValue(const char* aArg, const char* aName)
     {
-        LARGE_INTEGER frequency;
-        QueryPerformanceFrequency(&frequency);
+        const size_t nameLength(strlen(aName));
 
-        m_inverseFrequency = 1000000.0 / (double)frequency.QuadPart;
+        return (0 == strncmp(aArg, "--", 2) && 0 == strncmp(aArg + 2, aName, nameLength) && '=' == aArg[2 + nameLength]) ? aArg + 3 + nameLength : NULL;
     }
 
-    void Start()
+    /// <summary>
+    /// Prints one line of lock counters.
+    /// </summary>
+    void PrintLockStatistics(const char* aName, const MutexStatistics& aStatistics)
     {
-        QueryPerformanceCounter(&m_start);
+        LOG_MESSAGE(LL_SUMMARY, "Lock %s: %llu acquisitions, %llu contended, %.3f ms waiting\n", aName, aStatistics.m_acquisitions,
+            aStatistics.m_contendedAcquisitions, aStatistics.m_waitNanoseconds / 1000000.0);
     }
 
-    double Get()
+    /// <summary>
+    /// Prints mines left to every team and the winner, lowest team on ties.
+    /// </summary>
+    /// <param name="aMinesPerTeam">const std::vector<int>&. Mines left, per team</param>
+    /// <param name="aNumberOfTurns">int. Turns played</param>
+    void PrintWinner(const std::vector<int>& aMinesPerTeam, const int aNumberOfTurns)
     {
-        QueryPerformanceCounter(&m_stop);
-
-        double time = (double)(m_stop.QuadPart - m_start.QuadPart) * m_inverseFrequency;
-
-        m_start = m_stop;
+        for (int i = 0; i < static_cast<int>(aMinesPerTeam.size()); i++)
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Team %d has %d mines remaining\n", i, aMinesPerTeam[i]);
+        }
 
-        // time value is in micro seconds
-        return time;
+        LOG_MESSAGE(LL_SUMMARY, "Team %d WINS after %d turns!!\n", Simulation::GetWinningTeam(aMinesPerTeam), aNumberOfTurns);
     }
 
-    LARGE_INTEGER m_start;
-    LARGE_INTEGER m_stop;
-    double m_inverseFrequency;
-};
-#endif
-
-#ifdef __linux
-class QueryPerformanceTimer
-{
-public:
-    QueryPerformanceTimer()
+    /// <summary>
+    /// Plays a game split across shard processes, already started.
+    /// </summary>
+    /// <param name="aSimulation">ShardedSimulation&. Shards, stopped on return</param>
+    /// <param name="aSetupTime">double. Microseconds it took to start the shards and build their slabs</param>
+    void PlayShardedGame(ShardedSimulation& aSimulation, const double aSetupTime)
     {
+        std::vector<ShardResult> results;
 
-    }
+        if (!aSimulation.GetResults(results))
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Sharded game failed: %s\n", aSimulation.GetError());
+            return;
+        }
 
-    void Start()
-    {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        m_start = now.tv_sec + now.tv_nsec / 1000000000.0;
-    }
+        unsigned int numberOfObjects(0);
 
-    double Get()
-    {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        m_stop = now.tv_sec + now.tv_nsec / 1000000000.0;
+        for (int shard = 0; shard < static_cast<int>(results.size()); shard++)
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Shard %d holds %d mines and %d ghosts\n", shard, results[shard].m_numberOfMines, results[shard].m_numberOfGhosts);
 
-        double time = m_stop - m_start;
+            if (0 < results[shard].m_numberOfMinesDropped)
+            {
+                LOG_MESSAGE(LL_SUMMARY, "Shard %d dropped %d mines past the object limit\n", shard, results[shard].m_numberOfMinesDropped);
+            }
 
-        m_start = m_stop;
+            numberOfObjects += results[shard].m_numberOfMines;
+        }
 
-        // time value is in micro seconds
-        return time;
-    }
+        LOG_MESSAGE(LL_SUMMARY, "Number of objects in system %u\n", numberOfObjects);
 
-    double m_start;
-    double m_stop;
-};
-#endif
+        QueryPerformanceTimer timer;
+        timer.Start();
 
-class ScopedQueryPerformanceTimer
-{
-public:
-    ScopedQueryPerformanceTimer(const char* aMsg = NULL)
-    {
-        m_msg = aMsg;
-        m_timer.Start();
-    }
+        bool targetsStillFound(true);
 
-    ~ScopedQueryPerformanceTimer()
-    {
-        double timeUsed = m_timer.Get();
-        printf("%s %f\n", m_msg, timeUsed / 1000.0);
-    }
+        while (targetsStillFound && aSimulation.RunTurn(targetsStillFound))
+        {
+        }
 
-    QueryPerformanceTimer m_timer;
-    const char* m_msg;
-};
+        const double timeUsed(aSetupTime + timer.Get());
 
-static int s_numberOfWorkerThreadsActive = 0;
-static int s_numberOfWorkerThreadsStarted = 0;
-static int s_currentMineIndex = 0;
-static Mutex s_lock;
+        if (targetsStillFound || !aSimulation.GetResults(results))
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Sharded game failed: %s\n", aSimulation.GetError());
+            aSimulation.Stop();
+            return;
+        }
 
-namespace
-{
-    const int NextIndex(void) {
-        MutexLock lock(s_lock);
+        std::vector<int> minesPerTeam(g_numberOfTeams, 0);
+
+        for (const ShardResult& result : results)
+        {
+            for (int i = 0; i < g_numberOfTeams; i++)
+            {
+                minesPerTeam[i] += result.m_minesPerTeam[i];
+            }
+        }
 
-        int index = s_currentMineIndex;
+        PrintWinner(minesPerTeam, aSimulation.GetNumberOfTurns());
 
-        s_currentMineIndex++;
+        aSimulation.Stop();
 
-        return index;
+        LOG_MESSAGE(LL_SUMMARY, "Time taken in milliseconds: %f\n", timeUsed / 1000.0);
     }
+}
 
-    void FindTargets(void* aIgnored)
+int main(int aArgc, char* aArgv[])
+{
+    int numberOfWorkerThreads = 12;
+    int randomSeed = 654321;
+    TargetingBackend targetingBackend = TB_SPATIAL_GRID;
+    const char* loadPath(NULL);
+    const char* savePath(NULL);
+    const char* scenarioPath(NULL);
+    bool usePerfCounters(false);
+    int numberOfShards(0);
+    bool batchMode(false);
+    unsigned int firstBatchSeed(0);
+    unsigned int lastBatchSeed(0);
+    const char* batchOutputPath(NULL);
+
+    /* Optional "--name=value" switches can be placed anywhere, the rest keep their positional meaning */
+    std::vector<char*> arguments(1, aArgv[0]);
+
+    for (int i = 1; i < aArgc; i++)
     {
+        const char* value(NULL);
+
+        if (NULL != (value = GetOptionValue(aArgv[i], "targeting")))
         {
-            MutexLock lock(s_lock);
-            s_numberOfWorkerThreadsActive++;
-            s_numberOfWorkerThreadsStarted++;
+            if (!SpatialIndex::ParseBackend(value, targetingBackend))
+            {
+                printf("Unknown targeting backend '%s' (brute, grid, kdtree)\n", value);
+                return 1;
+            }
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "distribution")))
+        {
+            if (!Simulation::ParseDistribution(value, g_spawnDistribution))
+            {
+                printf("Unknown spawn distribution '%s' (uniform, clustered, sparse)\n", value);
+                return 1;
+            }
         }
-        bool done = false;
-        while (!done)
+        else if (NULL != (value = GetOptionValue(aArgv[i], "simd")))
         {
-            int index = NextIndex();
+            SimdLevel simdLevel(SL_SCALAR);
 
-            if (index < MineManager::GetInstance().GetNumberOfObjects())
+            if (!DistanceKernel::ParseLevel(value, simdLevel))
             {
-                Mine* pMineObject = MineManager::GetInstance().GetObjectByIndex(index);
+                printf("Unknown SIMD level '%s' (scalar, avx2, avx512)\n", value);
+                return 1;
+            }
+            if (!DistanceKernel::SetLevel(simdLevel))
+            {
+                printf("SIMD level '%s' is not supported by this CPU (best is %s)\n", value, DistanceKernel::GetLevelName(DistanceKernel::GetSupportedLevel()));
+                return 1;
+            }
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "retarget")))
+        {
+            if (0 == strcmp(value, "incremental") || 0 == strcmp(value, "full"))
+            {
+                MineManager::GetInstance().SetIncrementalTargeting(0 == strcmp(value, "incremental"));
+            }
+            else
+            {
+                printf("Unknown retarget mode '%s' (incremental, full)\n", value);
+                return 1;
+            }
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "target-lists")))
+        {
+            TargetListMode targetListMode(TL_FULL);
 
-                if (NULL != pMineObject)
-                {
-                    pMineObject->FindCurrentTargets();
-                }
+            if (!MineManager::ParseTargetListMode(value, targetListMode))
+            {
+                printf("Unknown target list mode '%s' (full, count)\n", value);
+                return 1;
+            }
+
+            MineManager::GetInstance().SetTargetListMode(targetListMode);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "lock-stats")))
+        {
+            if (0 == strcmp(value, "on") || 0 == strcmp(value, "off"))
+            {
+                Mutex::SetStatisticsEnabled(0 == strcmp(value, "on"));
+            }
+            else
+            {
+                printf("Unknown lock-stats value '%s' (on, off)\n", value);
+                return 1;
+            }
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "log")))
+        {
+            LogLevel logLevel(LL_MINE);
+
+            if (!Logger::ParseLevel(value, logLevel))
+            {
+                printf("Unknown log level '%s' (silent, summary, turn, mine)\n", value);
+                return 1;
+            }
+
+            Logger::SetLevel(logLevel);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "profile")))
+        {
+            ProfileMode profileMode(PM_OFF);
+
+            if (!Profiler::ParseMode(value, profileMode))
+            {
+                printf("Unknown profile mode '%s' (off, summary, turn)\n", value);
+                return 1;
+            }
+
+            Profiler::SetMode(profileMode);
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "perf-counters")))
+        {
+            if (0 == strcmp(value, "on") || 0 == strcmp(value, "off"))
+            {
+                usePerfCounters = 0 == strcmp(value, "on");
             }
             else
             {
-                done = true;
+                printf("Unknown perf-counters value '%s' (on, off)\n", value);
+                return 1;
+            }
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "shards")))
+        {
+            numberOfShards = atoi(value);
+
+            if (numberOfShards < 1)
+            {
+                printf("Invalid number of shards '%s'\n", value);
+                return 1;
             }
         }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "batch")))
+        {
+            if (2 != sscanf(value, "%u-%u", &firstBatchSeed, &lastBatchSeed) || lastBatchSeed < firstBatchSeed || lastBatchSeed - firstBatchSeed >= 100000000u)
+            {
+                printf("Invalid seed range '%s' (first-last)\n", value);
+                return 1;
+            }
+
+            batchMode = true;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "batch-output")))
+        {
+            batchOutputPath = value;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "load")))
+        {
+            loadPath = value;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "save")))
+        {
+            savePath = value;
+        }
+        else if (NULL != (value = GetOptionValue(aArgv[i], "scenario")))
+        {
+            scenarioPath = value;
+        }
+        else if (0 == strncmp(aArgv[i], "--", 2))
         {
-            MutexLock lock(s_lock);
-            s_numberOfWorkerThreadsActive--;
+            printf("Unknown option '%s'\n", aArgv[i]);
+            return 1;
+        }
+        else
+        {
+            arguments.push_back(aArgv[i]);
         }
     }
-}
 
-class WorkerThread
-{
-public:
+    const int argc(static_cast<int>(arguments.size()));
+
+    if (argc > 1)
+    {
+        randomSeed = atoi(arguments[1]);
+    }
+    if (argc > 2)
+    {
+        numberOfWorkerThreads = atoi(arguments[2]);
+    }
+    if (argc > 3)
+    {
+        g_numberOfTeams = atoi(arguments[3]);
+    }
+    if (argc > 4)
+    {
+        g_numberOfMinesPerTeam = atoi(arguments[4]);
+    }
+    if (argc > 5)
+    {
+        g_useHashIDs = atoi(arguments[5]) > 0;
+    }
 
-    WorkerThread()
+    /* Shards spawn their own slab of the generated field, with spawn ordinals for IDs */
+    if (0 < numberOfShards && (NULL != loadPath || NULL != savePath || NULL != scenarioPath || g_useHashIDs || Profiler::IsEnabled() || usePerfCounters))
     {
+        printf("--shards cannot be combined with --load, --save, --scenario, --profile, --perf-counters or hash IDs\n");
+        return 1;
     }
 
-    ~WorkerThread()
+    /* Batches only play generated fields, and only report their aggregate */
+    if (batchMode && (NULL != loadPath || NULL != savePath || NULL != scenarioPath || 0 < numberOfShards || Profiler::IsEnabled() || usePerfCounters))
     {
+        printf("--batch cannot be combined with --load, --save, --scenario, --shards, --profile or --perf-counters\n");
+        return 1;
     }
 
-    void FindTargetsForAllMines()
+    if (batchMode && Logger::IsEnabled(LL_TURN))
     {
-#ifdef __linux
-        pthread_t threadId = 0;
+        Logger::SetLevel(LL_SUMMARY);
+    }
 
-        pthread_attr_t attributes;
-        pthread_attr_init(&attributes);
+    /* A loaded field replaces the generated one, and brings its own number of teams */
+    MineSnapshot snapshot;
 
-        pthread_create(&threadId, &attributes, (void* (*)(void*))FindTargets, NULL);
-#elif _WIN32
-        _beginthread(FindTargets, 0, NULL);
-#endif
+    if (NULL != loadPath)
+    {
+        const SnapshotResult result(snapshot.Open(loadPath));
+
+        if (SR_OK != result)
+        {
+            printf("Cannot load snapshot '%s': %s\n", loadPath, MineSnapshot::GetResultName(result));
+            return 1;
+        }
+
+        g_numberOfTeams = snapshot.GetNumberOfTeams();
+        g_numberOfMinesPerTeam = g_numberOfTeams > 0 ? (snapshot.GetNumberOfMines() + g_numberOfTeams - 1) / g_numberOfTeams : 0;
     }
-};
 
-int main(int aArgc, char* aArgv[])
-{
-    int numberOfWorkerThreads = 12;
-    int randomSeed = 654321;
-    if (aArgc > 1)
+    /* A scenario file also replaces the generated field; teams outside the configured range are rejected */
+    ScenarioReader scenario(MineManager::GetInstance(), g_numberOfTeams);
+
+    if (NULL != scenarioPath && !scenario.Open(scenarioPath))
     {
-        randomSeed = atoi(aArgv[1]);
-        SetRandomSeed(randomSeed);
+        printf("Cannot read scenario '%s': %s\n", scenarioPath, scenario.GetErrorMessages().front().c_str());
+        return 1;
     }
-    if (aArgc > 2)
+
+    /* Always seeded, the manager keys its counter based draws on the same seed even when none was given */
+    SetRandomSeed(randomSeed);
+
+    /* Shard processes are forked before any thread exists, the logger one included */
+    ShardedSimulation shardedSimulation;
+    bool shardsStarted(false);
+    double shardSetupTime(0.0);
+
+    if (0 < numberOfShards)
     {
-        numberOfWorkerThreads = atoi(aArgv[2]);
+        const ShardSettings settings = { numberOfShards, numberOfWorkerThreads, g_numberOfTeams, g_numberOfMinesPerTeam, static_cast<unsigned int>(randomSeed),
+                                         g_spawnDistribution, MineManager::GetInstance().GetRadiusDistribution(), targetingBackend };
+        QueryPerformanceTimer timer;
+
+        timer.Start();
+        shardsStarted = shardedSimulation.Start(settings);
+        shardSetupTime = timer.Get();
     }
-    if (aArgc > 3)
+
+    /* Spawn and turn reports are queued and written by a background thread from here on */
+    Logger::Start();
+
+    LOG_MESSAGE(LL_SUMMARY, "Random seed: %d\n", randomSeed);
+    LOG_MESSAGE(LL_SUMMARY, "Number of worker threads: %d\n", numberOfWorkerThreads);
+    LOG_MESSAGE(LL_SUMMARY, "Number of teams: %d  \n", g_numberOfTeams);
+    LOG_MESSAGE(LL_SUMMARY, "Number of mines per team: %d\n", g_numberOfMinesPerTeam);
+    LOG_MESSAGE(LL_SUMMARY, "Targeting backend: %s\n", SpatialIndex::GetBackendName(targetingBackend));
+    LOG_MESSAGE(LL_SUMMARY, "Distance kernel: %s\n", DistanceKernel::GetLevelName(DistanceKernel::GetLevel()));
+    LOG_MESSAGE(LL_SUMMARY, "Retargeting: %s\n", MineManager::GetInstance().IsIncrementalTargeting() ? "incremental" : "full");
+    LOG_MESSAGE(LL_SUMMARY, "Target lists: %s\n", MineManager::GetTargetListModeName(MineManager::GetInstance().GetTargetListMode()));
+
+    if (0 < numberOfShards)
     {
-        g_numberOfTeams = atoi(aArgv[3]);
+        LOG_MESSAGE(LL_SUMMARY, "Shards: %d, split along x\n", numberOfShards);
     }
-    if (aArgc > 4)
+    if (batchMode)
     {
-        g_numberOfMinesPerTeam = atoi(aArgv[4]);
+        LOG_MESSAGE(LL_SUMMARY, "Batch: seeds %u to %u, one game per worker thread at once\n", firstBatchSeed, lastBatchSeed);
     }
-    if (aArgc > 5)
+
+    /* Counters are a diagnostic, the run goes on without them */
+    if (usePerfCounters && !PerfCounters::Enable())
     {
-        g_useHashIDs = atoi(aArgv[5]) > 0;
+        LOG_MESSAGE(LL_SUMMARY, "Performance counters unavailable: %s\n", PerfCounters::GetUnavailableReason());
     }
 
-    printf("Random seed: %d\n", randomSeed);
-    printf("Number of worker threads: %d\n", numberOfWorkerThreads);
-    printf("Number of teams: %d  \n", g_numberOfTeams);
-    printf("Number of mines per team: %d\n", g_numberOfMinesPerTeam);
+    if (batchMode)
+    {
+        const BatchSettings settings = { firstBatchSeed, static_cast<int>(lastBatchSeed - firstBatchSeed + 1), numberOfWorkerThreads, g_numberOfTeams,
+                                         g_numberOfMinesPerTeam, g_spawnDistribution, targetingBackend,
+                                         MineManager::GetInstance().IsIncrementalTargeting(), MineManager::GetInstance().GetTargetListMode(), g_useHashIDs };
+        BatchRunner batch;
 
+        if (batch.Run(settings, batchOutputPath))
+        {
+            batch.PrintSummary();
+        }
+        else
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Batch failed: %s\n", batch.GetError());
+        }
+    }
+    else if (0 < numberOfShards)
     {
-        ScopedQueryPerformanceTimer timer("Time taken in milliseconds:");
+        if (shardsStarted)
+        {
+            PlayShardedGame(shardedSimulation, shardSetupTime);
+        }
+        else
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Cannot start shards: %s\n", shardedSimulation.GetError());
+        }
+    }
+    else
+    {
+        /* Covers building the field and playing; printing and saving it are left out */
+        QueryPerformanceTimer timer;
+        timer.Start();
 
+        MineManager::GetInstance().SetRandomSeed(randomSeed);
+        MineManager::GetInstance().SetTargetingBackend(targetingBackend);
         MineManager::GetInstance().Init(g_numberOfTeams, g_numberOfMinesPerTeam);
 
-        // Let's add lots of mine objects to the system before starting things up
-        for (int i = 0; i < g_numberOfTeams; i++)
-        {
-            for (int j = 0; j < g_numberOfMinesPerTeam; j++)
-            {
-                Vector3 position{ GetRandomFloat32_Range(-1000.0f, 1000.0f),
-                                   GetRandomFloat32_Range(-1000.0f, 1000.0f),
-                                   GetRandomFloat32_Range(-1000.0f, 1000.0f) };
-
-                unsigned int objectId(g_useHashIDs ?
-                    static_cast<unsigned int>(std::hash<unsigned int>()(j * (i + 1))) :  GetRandomUInt32() % (g_numberOfMinesPerTeam * 10));
+        /* Threads are spawned once and reused to build the field and every turn */
+        WorkerPool workerPool;
+        workerPool.Start(numberOfWorkerThreads);
 
-                const Mine* cachedMine(MineManager::GetInstance().AddMineObject(objectId, position, i));
+        Simulation simulation(MineManager::GetInstance(), workerPool, g_numberOfTeams);
+        int firstSlot(0);
 
-                printf("Object id %d position (%0.3f, %0.3f, %0.3f) active %s invulnerable %s\n", cachedMine->GetObjectId(),
-                    cachedMine->GetPosition().x, cachedMine->GetPosition().y, cachedMine->GetPosition().z, cachedMine->IsActive() ? "Y" : "N", cachedMine->IsInvulnerable() ? "Y" : "N");
-            }
+        if (NULL != loadPath)
+        {
+            MineManager::GetInstance().LoadSnapshot(snapshot);
+            snapshot.Close();
         }
-
-        printf("Number of objects in system %u\n", MineManager::GetInstance().GetNumberOfObjects());
-
-        std::vector<WorkerThread> workerThreadList;
-        workerThreadList.reserve(numberOfWorkerThreads);
-
-        for (int i = 0; i < numberOfWorkerThreads; i++)
+        else if (NULL != scenarioPath)
+        {
+            scenario.Read(workerPool);
+        }
+        else
         {
-            workerThreadList.emplace_back();
+            firstSlot = simulation.SpawnMines(g_numberOfMinesPerTeam, g_spawnDistribution, g_useHashIDs);
         }
 
-        int numberOfTurns = 0;
-        bool targetsStillFound = true;
+        double timeUsed(timer.Get());
 
-        while (targetsStillFound)
+        if (NULL != scenarioPath)
         {
-            numberOfTurns++;
-            targetsStillFound = false;
-            s_numberOfWorkerThreadsStarted = 0;
-            s_currentMineIndex = 0;
-
-            for (int i = 0; i < numberOfWorkerThreads; i++)
+            for (const std::string& message : scenario.GetErrorMessages())
             {
-                workerThreadList[i].FindTargetsForAllMines();
+                LOG_MESSAGE(LL_SUMMARY, "Scenario %s\n", message.c_str());
             }
-
-            do
+            for (int error = 0; error < SE_COUNT; error++)
             {
-                // sleep until all worker threads have finished doing their thing
-#ifdef __linux
-                usleep(1000);
-#elif _WIN32
-                Sleep(1);
-#endif
-            } while (s_numberOfWorkerThreadsActive > 0 || s_numberOfWorkerThreadsStarted == 0);
+                if (0 < scenario.GetNumberOfErrors(static_cast<ScenarioError>(error)))
+                {
+                    LOG_MESSAGE(LL_SUMMARY, "Scenario skipped %lld records: %s\n", scenario.GetNumberOfErrors(static_cast<ScenarioError>(error)),
+                        ScenarioReader::GetErrorName(static_cast<ScenarioError>(error)));
+                }
+            }
+        }
 
-            for (int i = 0; i < g_numberOfTeams; i++)
-            {
-                Mine* pMine = MineManager::GetInstance().GetObjectWithMostEnemyTargets(i);
+        for (int i = firstSlot; Logger::IsEnabled(LL_MINE) && i < MineManager::GetInstance().GetStorage().GetSize(); i++)
+        {
+            const Mine* cachedMine(MineManager::GetInstance().GetObjectByIndex(i));
 
-                int enemyTargets = NULL != pMine ? pMine->GetNumberOfTargets() : 0;
+            LOG_MESSAGE(LL_MINE, "Object id %d position (%0.3f, %0.3f, %0.3f) active %s invulnerable %s\n", cachedMine->GetObjectId(),
+                cachedMine->GetPosition().x, cachedMine->GetPosition().y, cachedMine->GetPosition().z, cachedMine->IsActive() ? "Y" : "N", cachedMine->IsInvulnerable() ? "Y" : "N");
+        }
 
-                if (0 < enemyTargets)
-                {
-                    pMine->Explode();
+        LOG_MESSAGE(LL_SUMMARY, "Number of objects in system %u\n", MineManager::GetInstance().GetNumberOfObjects());
 
-                    targetsStillFound = true;
+        if (NULL != savePath)
+        {
+            const SnapshotResult result(MineSnapshot::Save(savePath, MineManager::GetInstance().GetStorage(), g_numberOfTeams));
 
-                    if (5 > numberOfTurns)
-                    {
-                        printf("Turn %d: Team %d picks Mine with object id %d (with %d targets) to explode\n", numberOfTurns, i,
-                            pMine->GetObjectId(), enemyTargets);
-                    }
-                }
+            if (SR_OK != result)
+            {
+                LOG_MESSAGE(LL_SUMMARY, "Cannot save snapshot '%s': %s\n", savePath, MineSnapshot::GetResultName(result));
             }
         }
 
-        int winningTeam = 0;
-        int winningObjectCount = 0;
+        timer.Start();
+
+        while (simulation.RunTurn())
+        {
+        }
+
+        timeUsed += timer.Get();
+
+        std::vector<int> minesPerTeam;
+
         for (int i = 0; i < g_numberOfTeams; i++)
         {
-            int noOfTargets = MineManager::GetInstance().GetNumberOfObjectForTeam(i);
+            minesPerTeam.push_back(MineManager::GetInstance().GetNumberOfObjectForTeam(i));
+        }
 
-            printf("Team %d has %d mines remaining\n", i, noOfTargets);
+        PrintWinner(minesPerTeam, simulation.GetNumberOfTurns());
 
-            if (noOfTargets > winningObjectCount)
-            {
-                winningObjectCount = noOfTargets;
-                winningTeam = i;
-            }
+        if (Profiler::IsEnabled())
+        {
+            Profiler::PrintSummary();
+        }
+
+        if (PerfCounters::IsEnabled())
+        {
+            PerfCounters::PrintSummary();
         }
 
-        printf("Team %d WINS after %d turns!!\n", winningTeam, numberOfTurns);
+        if (Mutex::IsStatisticsEnabled())
+        {
+            PrintLockStatistics("MineManager", MineManager::GetInstance().GetLockStatistics());
+            PrintLockStatistics("Scheduler", workerPool.GetSchedulerLockStatistics());
+        }
 
-        workerThreadList.clear();
+        workerPool.Stop();
 
         MineManager::GetInstance().Dispose();
+
+        LOG_MESSAGE(LL_SUMMARY, "Time taken in milliseconds: %f\n", timeUsed / 1000.0);
     }
 
+    Logger::Stop();
+
 #ifdef __linux
     usleep(-1);
 #elif _WIN32
@@ -3,23 +3,55 @@
 
 #ifdef _WIN32
 #include "stdafx.h"
-#include <intrin.h>
+#include "Windows.h"
 
 #pragma once
-#pragma intrinsic(_InterlockedExchange)
-#pragma intrinsic(_InterlockedCompareExchange)
+#pragma comment(lib, "Synchronization.lib")
+#elif __linux
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define MUTEX_PAUSE() _mm_pause()
+#else
+#define MUTEX_PAUSE()
 #endif
 
+#include <atomic>
+#include <chrono>
+
+/// <summary>
+/// Lock usage counters, only collected while Mutex::SetStatisticsEnabled(true).
+/// </summary>
+struct MutexStatistics
+{
+    unsigned long long m_acquisitions;
+    /* Acquisitions that found the lock taken */
+    unsigned long long m_contendedAcquisitions;
+    /* Time spent spinning or parked before a contended acquisition succeeded */
+    unsigned long long m_waitNanoseconds;
+};
+
+/// <summary>
+/// Adaptive lock: an uncontended Lock is a single compare-and-swap; a contended one spins briefly
+/// with pause, hoping the holder is about to release, and then parks the thread on a futex
+/// (WaitOnAddress on Windows) so waiters do not burn cores while the lock is held.
+/// </summary>
 class Mutex
 {
 public:
     enum LockState
     {
         LS_LOCK_IS_FREE = 0,
-        LS_LOCK_IS_TAKEN = 1
+        LS_LOCK_IS_TAKEN = 1,
+        /* Taken and someone may be parked, Unlock has to wake a waiter */
+        LS_LOCK_HAS_WAITERS = 2
     };
 
-    Mutex() : m_spinLock(LS_LOCK_IS_FREE)
+    Mutex() : m_state(LS_LOCK_IS_FREE), m_acquisitions(0), m_contendedAcquisitions(0), m_waitNanoseconds(0)
     {
     }
 
@@ -27,29 +59,125 @@ public:
     {
     }
 
-#ifdef _WIN32
     void Lock()
     {
-        while(_InterlockedCompareExchange(&m_spinLock, LS_LOCK_IS_TAKEN, LS_LOCK_IS_FREE));
+        int expected(LS_LOCK_IS_FREE);
+
+        if (m_state.compare_exchange_strong(expected, LS_LOCK_IS_TAKEN, std::memory_order_acquire))
+        {
+            if (IsStatisticsEnabled())
+            {
+                m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            LockContended();
+        }
     }
 
     void Unlock()
     {
-        _InterlockedExchange(&m_spinLock, LS_LOCK_IS_FREE);
+        if (LS_LOCK_HAS_WAITERS == m_state.exchange(LS_LOCK_IS_FREE, std::memory_order_release))
+        {
+            Wake();
+        }
+    }
+
+    /// <summary>
+    /// Returns counters collected so far. Values are read without synchronization, call it once the
+    /// threads using the lock are idle.
+    /// </summary>
+    /// <returns>MutexStatistics. Counters</returns>
+    MutexStatistics GetStatistics(void) const
+    {
+        return { m_acquisitions.load(std::memory_order_relaxed), m_contendedAcquisitions.load(std::memory_order_relaxed), m_waitNanoseconds.load(std::memory_order_relaxed) };
+    }
+
+    /// <summary>
+    /// Turns statistics collection on or off for every Mutex. Off by default.
+    /// </summary>
+    /// <param name="aEnabled">bool. Collect or not</param>
+    static void SetStatisticsEnabled(const bool aEnabled) { StatisticsEnabled() = aEnabled; }
+    /// <summary>
+    /// Returns if statistics are being collected.
+    /// </summary>
+    /// <returns>bool. True if enabled</returns>
+    static bool IsStatisticsEnabled(void) { return StatisticsEnabled(); }
+
+private:
+    /* Spins before parking, roughly a microsecond worth of pause instructions */
+    static const int cSpinCount = 64;
+
+    static bool& StatisticsEnabled(void)
+    {
+        static bool s_enabled(false);
+        return s_enabled;
+    }
+
+    void LockContended()
+    {
+        const bool collect(IsStatisticsEnabled());
+        const std::chrono::steady_clock::time_point start(collect ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point());
+
+        bool acquired(false);
+
+        for (int i = 0; i < cSpinCount && !acquired; ++i)
+        {
+            MUTEX_PAUSE();
+
+            int expected(LS_LOCK_IS_FREE);
+            acquired = LS_LOCK_IS_FREE == m_state.load(std::memory_order_relaxed) &&
+                       m_state.compare_exchange_weak(expected, LS_LOCK_IS_TAKEN, std::memory_order_acquire);
+        }
+
+        if (!acquired)
+        {
+            /* Flag the lock as having waiters before parking; whoever owned it will wake us on Unlock.
+            If it was freed meanwhile, the exchange itself acquires it */
+            while (LS_LOCK_IS_FREE != m_state.exchange(LS_LOCK_HAS_WAITERS, std::memory_order_acquire))
+            {
+                Wait(LS_LOCK_HAS_WAITERS);
+            }
+        }
+
+        if (collect)
+        {
+            const long long waited(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+            m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+            m_contendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+            m_waitNanoseconds.fetch_add(static_cast<unsigned long long>(waited), std::memory_order_relaxed);
+        }
+    }
+
+#ifdef _WIN32
+    void Wait(int aExpected)
+    {
+        WaitOnAddress(&m_state, &aExpected, sizeof(aExpected), INFINITE);
+    }
+
+    void Wake()
+    {
+        WakeByAddressSingle(&m_state);
     }
 #elif __linux
-    void Lock()
+    void Wait(const int aExpected)
     {
-        while(__sync_val_compare_and_swap(&m_spinLock, LS_LOCK_IS_TAKEN, LS_LOCK_IS_FREE));
+        /* Returns right away if the value already changed, spurious wake ups are handled by the caller loop */
+        syscall(SYS_futex, reinterpret_cast<int*>(&m_state), FUTEX_WAIT_PRIVATE, aExpected, NULL, NULL, 0);
     }
 
-    void Unlock()
+    void Wake()
     {
-        __sync_lock_test_and_set(&m_spinLock, LS_LOCK_IS_FREE);
+        syscall(SYS_futex, reinterpret_cast<int*>(&m_state), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
     }
 #endif
 
-    volatile long m_spinLock;
+    std::atomic<int> m_state;
+    std::atomic<unsigned long long> m_acquisitions;
+    std::atomic<unsigned long long> m_contendedAcquisitions;
+    std::atomic<unsigned long long> m_waitNanoseconds;
 };
 
 class MutexLock
@@ -4,9 +4,6 @@
 #pragma once
 
 #include "Mutex.h"
-#include <unordered_map>
-#include <vector>
-#include <memory>
 
 const int cMaximumNumberOfObjects = 1000000;
 
@@ -19,7 +16,7 @@ public:
     ObjectManager& operator=(const ObjectManager&) = delete;
 
     /// <summary>
-    /// Initializes size of collection based on inputs
+    /// Initializes size of collection based on inputs. Derived managers reserve their storage here.
     /// </summary>
     /// <param name="aPools">int. Number of pools</param>
     /// <param name="aObjectPerPool">int. Number of elements per pool</param>
@@ -72,30 +69,17 @@ public:
     /// </summary>
     /// <returns>int. Number of existing objects</returns>
     inline const int GetNumberOfObjects(void) const { return m_numberOfObjects; }
+    /// <summary>
+    /// Returns counters of the lock guarding collection changes.
+    /// </summary>
+    /// <returns>MutexStatistics. Lock counters</returns>
+    inline MutexStatistics GetLockStatistics(void) const { return m_lock.GetStatistics(); }
 
 protected:
     ObjectManager(void);
     virtual ~ObjectManager(void);
 
-    struct ObjectIndexData {
-        int m_poolID = 0;
-        int m_actualIndex = 0;
-    };
-
-    /// <summary>
-    /// Returns object relative index based on absolute index.
-    /// </summary>
-    /// <param name="in_absIndex">int. Absolute index</param>
-    /// <returns>ObjectIndexData. Object relative position data</returns>
-    const ObjectIndexData GetObjectIndex(const int aAbsIndex)
-    {
-        int poolID((int)((aAbsIndex / (float)(m_objectPerPool * m_numberOfPools)) * m_numberOfPools));
-
-        return { poolID, aAbsIndex - (m_objectPerPool * poolID) };
-    }
-
     Mutex m_lock;
-    std::unordered_map<int, std::vector<TClass>> m_mObject;
     int m_numberOfObjects;
     int m_numberOfPools;
     int m_objectPerPool;
@@ -120,18 +104,6 @@ void ObjectManager<TClass>::Init(const int in_pools, const int in_objectPerPool)
 {
     m_numberOfPools = in_pools;
     m_objectPerPool = in_objectPerPool;
-
-    for (int i = 0; i < in_pools; i++)
-    {
-        /* Setting pool id. This step is required in order to reduce allocation overhead*/
-        m_mObject[i].reserve(in_objectPerPool);
-    }
 }
 
-//template<typename TClass>
-//void ObjectManager<TClass>::Dispose(void)
-//{
-//    m_mObject.clear();
-//}
-
 #endif // OBJECTMANAGER_H
\ No newline at end of file
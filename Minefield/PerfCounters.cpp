@@ -0,0 +1,283 @@
+#include "stdafx.h"
+#include "PerfCounters.h"
+#include "Logger.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <vector>
+#ifdef __linux
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+bool PerfCounters::s_enabled(false);
+
+namespace
+{
+    const char* const cCounterNames[PC_COUNT] = { "instructions", "cycles", "cache misses", "branch misses" };
+
+    /// <summary>
+    /// Counts of one thread, per phase. Outlive the thread, so totals survive pool restarts.
+    /// </summary>
+    struct ThreadTotals
+    {
+        unsigned long long m_value[SP_COUNT][PC_COUNT];
+    };
+
+    std::mutex s_threadsLock;
+    std::vector<std::unique_ptr<ThreadTotals>> s_threads;
+    /* Events that could be opened by Enable */
+    bool s_available[PC_COUNT];
+    std::string s_unavailableReason;
+
+#ifdef __linux
+    const unsigned long long cCounterConfigs[PC_COUNT] = { PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+                                                           PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+    /// <summary>
+    /// Counter group of the calling thread. Events are closed when the thread exits.
+    /// </summary>
+    struct CounterGroup
+    {
+        CounterGroup() : m_leader(-1), m_numberOfEvents(0), m_pTotals(NULL)
+        {
+            for (int counter = 0; counter < PC_COUNT; counter++)
+            {
+                m_fd[counter] = -1;
+                m_slot[counter] = -1;
+            }
+        }
+
+        ~CounterGroup()
+        {
+            for (int counter = 0; counter < PC_COUNT; counter++)
+            {
+                if (m_fd[counter] >= 0)
+                {
+                    close(m_fd[counter]);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Opens every event the kernel accepts, the first one leading the group.
+        /// </summary>
+        /// <returns>int. errno of the first failure, 0 if none failed</returns>
+        int Open(void)
+        {
+            int error(0);
+
+            for (int counter = 0; counter < PC_COUNT; counter++)
+            {
+                struct perf_event_attr attributes;
+
+                memset(&attributes, 0, sizeof(attributes));
+                attributes.size = sizeof(attributes);
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = cCounterConfigs[counter];
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+                attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                /* This thread, any CPU */
+                const int fd(static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, m_leader, 0)));
+
+                if (fd < 0)
+                {
+                    error = 0 == error ? errno : error;
+                    continue;
+                }
+
+                m_fd[counter] = fd;
+                m_slot[counter] = m_numberOfEvents++;
+                m_leader = m_leader < 0 ? fd : m_leader;
+            }
+
+            return error;
+        }
+
+        /// <summary>
+        /// Reads every event of the group at once, scaled up if the kernel had to multiplex them.
+        /// </summary>
+        void Read(unsigned long long* aValues) const
+        {
+            /* nr, time enabled, time running, one value per event */
+            unsigned long long buffer[3 + PC_COUNT];
+
+            memset(aValues, 0, sizeof(unsigned long long) * PC_COUNT);
+
+            if (m_leader < 0 || read(m_leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(unsigned long long) * (3 + m_numberOfEvents)))
+            {
+                return;
+            }
+
+            const double scale(0 < buffer[2] && buffer[2] < buffer[1] ? static_cast<double>(buffer[1]) / buffer[2] : 1.0);
+
+            for (int counter = 0; counter < PC_COUNT; counter++)
+            {
+                if (m_slot[counter] >= 0)
+                {
+                    aValues[counter] = static_cast<unsigned long long>(buffer[3 + m_slot[counter]] * scale);
+                }
+            }
+        }
+
+        int m_fd[PC_COUNT];
+        /* Position of each event in a group read, -1 if not opened */
+        int m_slot[PC_COUNT];
+        int m_leader;
+        int m_numberOfEvents;
+        ThreadTotals* m_pTotals;
+    };
+
+    thread_local CounterGroup s_group;
+
+    /// <summary>
+    /// Returns counter group of the calling thread, opening it and registering its totals on first use.
+    /// </summary>
+    CounterGroup& GetGroup(void)
+    {
+        if (NULL == s_group.m_pTotals)
+        {
+            std::lock_guard<std::mutex> lock(s_threadsLock);
+
+            s_threads.emplace_back(new ThreadTotals());
+            memset(s_threads.back().get(), 0, sizeof(ThreadTotals));
+            s_group.m_pTotals = s_threads.back().get();
+            s_group.Open();
+        }
+
+        return s_group;
+    }
+#endif
+}
+
+bool PerfCounters::Enable(void)
+{
+#ifdef __linux
+    CounterGroup& group(GetGroup());
+
+    for (int counter = 0; counter < PC_COUNT; counter++)
+    {
+        s_available[counter] = group.m_slot[counter] >= 0;
+    }
+
+    if (0 == group.m_numberOfEvents)
+    {
+        /* Probe again to get the reason, the group itself stays empty */
+        CounterGroup probe;
+        const int error(probe.Open());
+
+        s_unavailableReason = std::string("perf_event_open failed: ") + strerror(0 != error ? error : ENOENT) +
+            (ENOENT == error ? " (no hardware events, virtual machine?)" : EACCES == error || EPERM == error ? " (see kernel.perf_event_paranoid)" : "");
+        return false;
+    }
+
+    s_enabled = true;
+    return true;
+#else
+    s_unavailableReason = "only supported on Linux";
+    return false;
+#endif
+}
+
+const char* PerfCounters::GetUnavailableReason(void)
+{
+    return s_unavailableReason.c_str();
+}
+
+const char* PerfCounters::GetCounterName(const PerfCounter aCounter)
+{
+    return aCounter >= 0 && aCounter < PC_COUNT ? cCounterNames[aCounter] : "unknown";
+}
+
+void PerfCounters::Read(unsigned long long* aValues)
+{
+#ifdef __linux
+    GetGroup().Read(aValues);
+#else
+    memset(aValues, 0, sizeof(unsigned long long) * PC_COUNT);
+#endif
+}
+
+void PerfCounters::Add(const SimulationPhase aPhase, const unsigned long long* aStart, const unsigned long long* aEnd)
+{
+#ifdef __linux
+    ThreadTotals& totals(*GetGroup().m_pTotals);
+
+    for (int counter = 0; counter < PC_COUNT; counter++)
+    {
+        /* Scaled reads are estimates and may step back a little */
+        totals.m_value[aPhase][counter] += aEnd[counter] > aStart[counter] ? aEnd[counter] - aStart[counter] : 0;
+    }
+#endif
+}
+
+PerfCounterValues PerfCounters::GetTotals(const SimulationPhase aPhase)
+{
+    std::lock_guard<std::mutex> lock(s_threadsLock);
+
+    PerfCounterValues values = {};
+
+    for (int counter = 0; counter < PC_COUNT; counter++)
+    {
+        values.m_available[counter] = s_enabled && s_available[counter];
+    }
+
+    for (const std::unique_ptr<ThreadTotals>& totals : s_threads)
+    {
+        for (int counter = 0; counter < PC_COUNT; counter++)
+        {
+            values.m_value[counter] += totals->m_value[aPhase][counter];
+        }
+    }
+
+    return values;
+}
+
+void PerfCounters::Reset(void)
+{
+    std::lock_guard<std::mutex> lock(s_threadsLock);
+
+    for (const std::unique_ptr<ThreadTotals>& totals : s_threads)
+    {
+        memset(totals.get(), 0, sizeof(ThreadTotals));
+    }
+}
+
+void PerfCounters::PrintSummary(void)
+{
+    const SimulationPhase cCountedPhases[] = { SP_TARGETING, SP_EXPLOSION };
+
+    for (const SimulationPhase phase : cCountedPhases)
+    {
+        const PerfCounterValues values(GetTotals(phase));
+        std::string line;
+        char text[64];
+
+        for (int counter = 0; counter < PC_COUNT; counter++)
+        {
+            if (values.m_available[counter])
+            {
+                snprintf(text, sizeof(text), "%s%llu %s", line.empty() ? "" : ", ", values.m_value[counter], cCounterNames[counter]);
+            }
+            else
+            {
+                snprintf(text, sizeof(text), "%sn/a %s", line.empty() ? "" : ", ", cCounterNames[counter]);
+            }
+
+            line += text;
+        }
+
+        if (values.m_available[PC_INSTRUCTIONS] && values.m_available[PC_CYCLES] && 0 < values.m_value[PC_CYCLES])
+        {
+            snprintf(text, sizeof(text), ", IPC %.2f", static_cast<double>(values.m_value[PC_INSTRUCTIONS]) / values.m_value[PC_CYCLES]);
+            line += text;
+        }
+
+        LOG_MESSAGE(LL_SUMMARY, "Counters %s: %s\n", Simulation::GetPhaseName(phase), line.c_str());
+    }
+}
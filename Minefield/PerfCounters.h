@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Simulation.h"
+
+/* Hardware events counted per thread */
+enum PerfCounter
+{
+    PC_INSTRUCTIONS = 0,
+    PC_CYCLES,
+    PC_CACHE_MISSES,
+    PC_BRANCH_MISSES,
+    PC_COUNT
+};
+
+/// <summary>
+/// Counter totals of a phase, every thread added up.
+/// </summary>
+struct PerfCounterValues
+{
+    unsigned long long m_value[PC_COUNT];
+    /* Whether the event could be opened, values of the others are 0 */
+    bool m_available[PC_COUNT];
+};
+
+/// <summary>
+/// Optional hardware performance counters (Linux perf_event_open). Each thread opens its own counter
+/// group the first time it enters a PerfCounterScope and only counts its own user space work; scopes
+/// read the group when entered and left and add the difference to the phase of the calling thread.
+/// Events the kernel or the virtual machine does not expose are left out, and when none can be
+/// opened everything turns into a no-op, so a run never fails because of them.
+/// </summary>
+class PerfCounters
+{
+public:
+    /// <summary>
+    /// Turns counting on, after checking on the calling thread that at least one event can be opened.
+    /// Call before worker threads start counting.
+    /// </summary>
+    /// <returns>bool. False if no counter is available, see GetUnavailableReason</returns>
+    static bool Enable(void);
+    /// <summary>
+    /// Whether scopes count.
+    /// </summary>
+    /// <returns>bool. True once Enable succeeded</returns>
+    static bool IsEnabled(void) { return s_enabled; }
+    /// <summary>
+    /// Returns why Enable failed.
+    /// </summary>
+    /// <returns>const char*. Reason, empty if Enable was not called or succeeded</returns>
+    static const char* GetUnavailableReason(void);
+    /// <summary>
+    /// Returns printable counter name.
+    /// </summary>
+    /// <param name="aCounter">PerfCounter. Counter</param>
+    /// <returns>const char*. Name</returns>
+    static const char* GetCounterName(const PerfCounter aCounter);
+    /// <summary>
+    /// Returns totals of a phase since the last Reset. Call while no scope is open.
+    /// </summary>
+    /// <param name="aPhase">SimulationPhase. Phase</param>
+    /// <returns>PerfCounterValues. Totals</returns>
+    static PerfCounterValues GetTotals(const SimulationPhase aPhase);
+    /// <summary>
+    /// Clears totals. Call while no scope is open.
+    /// </summary>
+    static void Reset(void);
+    /// <summary>
+    /// Logs totals, IPC and miss rates of every counted phase.
+    /// </summary>
+    static void PrintSummary(void);
+
+private:
+    friend class PerfCounterScope;
+
+    /// <summary>
+    /// Reads counter group of the calling thread, opening it on first use.
+    /// </summary>
+    /// <param name="aValues">unsigned long long*. PC_COUNT values, unavailable ones left at 0</param>
+    static void Read(unsigned long long* aValues);
+    /// <summary>
+    /// Adds counts to a phase of the calling thread.
+    /// </summary>
+    static void Add(const SimulationPhase aPhase, const unsigned long long* aStart, const unsigned long long* aEnd);
+
+    static bool s_enabled;
+};
+
+/// <summary>
+/// Counts the enclosing scope into a phase, for the calling thread only.
+/// </summary>
+class PerfCounterScope
+{
+public:
+    explicit PerfCounterScope(const SimulationPhase aPhase) :
+        m_phase(aPhase)
+    {
+        if (PerfCounters::IsEnabled())
+        {
+            PerfCounters::Read(m_start);
+        }
+    }
+
+    ~PerfCounterScope()
+    {
+        if (PerfCounters::IsEnabled())
+        {
+            unsigned long long end[PC_COUNT];
+
+            PerfCounters::Read(end);
+            PerfCounters::Add(m_phase, m_start, end);
+        }
+    }
+
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+
+private:
+    const SimulationPhase m_phase;
+    unsigned long long m_start[PC_COUNT];
+};
@@ -0,0 +1,240 @@
+#include "stdafx.h"
+#include "Profiler.h"
+#include "Logger.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <vector>
+
+ProfileMode Profiler::s_mode(PM_OFF);
+
+namespace
+{
+    const char* const cZoneNames[PZ_COUNT] = { "turn", "prepare targeting", "targeting", "worker wakeup", "find targets",
+                                               "selection", "explosion", "chain reaction", "removal" };
+    /* Reporting tree, -1 for the root */
+    const int cZoneParents[PZ_COUNT] = { -1, PZ_TURN, PZ_TURN, PZ_TARGETING, PZ_TARGETING, PZ_TURN, PZ_TURN, PZ_EXPLOSION, PZ_EXPLOSION };
+    const char* const cModeNames[] = { "off", "summary", "turn" };
+
+    /// <summary>
+    /// Zone times of one thread. Written by its thread only, read and cleared by EndTurn while the thread is idle.
+    /// </summary>
+    struct ThreadProfile
+    {
+        /* Current turn, microseconds */
+        double m_turnTime[PZ_COUNT];
+        /* Whole run, microseconds */
+        double m_runTime[PZ_COUNT];
+        unsigned long long m_runCount[PZ_COUNT];
+    };
+
+    /// <summary>
+    /// Zone times of one turn, every thread added up.
+    /// </summary>
+    struct TurnProfile
+    {
+        double m_time[PZ_COUNT];
+    };
+
+    /* Registration only; buffers themselves are never shared while in use */
+    std::mutex s_threadsLock;
+    std::vector<std::unique_ptr<ThreadProfile>> s_threads;
+    thread_local ThreadProfile* s_pThreadProfile(NULL);
+    std::vector<TurnProfile> s_turns;
+
+    /// <summary>
+    /// Returns calling thread buffer, registering it on first use.
+    /// </summary>
+    ThreadProfile& GetThreadProfile(void)
+    {
+        if (NULL == s_pThreadProfile)
+        {
+            std::lock_guard<std::mutex> lock(s_threadsLock);
+
+            s_threads.emplace_back(new ThreadProfile());
+            memset(s_threads.back().get(), 0, sizeof(ThreadProfile));
+            s_pThreadProfile = s_threads.back().get();
+        }
+
+        return *s_pThreadProfile;
+    }
+
+    /// <summary>
+    /// Appends "name time" of aZone to aLine, followed by its children between brackets.
+    /// </summary>
+    void AppendTurnBreakdown(const TurnProfile& aTurn, const int aZone, std::string& aLine)
+    {
+        char text[64];
+
+        snprintf(text, sizeof(text), "%s %.3f", cZoneNames[aZone], aTurn.m_time[aZone] / 1000.0);
+        aLine += text;
+
+        bool first(true);
+
+        for (int child = 0; child < PZ_COUNT; child++)
+        {
+            if (aZone == cZoneParents[child])
+            {
+                aLine += first ? " [" : ", ";
+                AppendTurnBreakdown(aTurn, child, aLine);
+                first = false;
+            }
+        }
+
+        if (!first)
+        {
+            aLine += "]";
+        }
+    }
+
+    /// <summary>
+    /// Logs statistics of aZone over every turn, then of its children, indented by depth.
+    /// </summary>
+    void PrintZoneSummary(const int aZone, const int aDepth, const unsigned long long* aCounts)
+    {
+        std::vector<double> samples;
+        double total(0.0);
+
+        samples.reserve(s_turns.size());
+
+        for (const TurnProfile& turn : s_turns)
+        {
+            samples.push_back(turn.m_time[aZone] / 1000.0);
+            total += samples.back();
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        const size_t p99(samples.empty() ? 0 : std::min(samples.size() - 1, (samples.size() * 99 + 99) / 100 - 1));
+
+        LOG_MESSAGE(LL_SUMMARY, "Profile %*s%-*s %10llu %12.3f %10.3f %10.3f %10.3f\n", aDepth * 2, "", 20 - aDepth * 2, cZoneNames[aZone],
+            aCounts[aZone], total, samples.empty() ? 0.0 : samples.front(), samples.empty() ? 0.0 : total / samples.size(),
+            samples.empty() ? 0.0 : samples[p99]);
+
+        for (int child = 0; child < PZ_COUNT; child++)
+        {
+            if (aZone == cZoneParents[child])
+            {
+                PrintZoneSummary(child, aDepth + 1, aCounts);
+            }
+        }
+    }
+}
+
+bool Profiler::ParseMode(const char* aName, ProfileMode& aOutMode)
+{
+    for (int mode = PM_OFF; mode <= PM_TURN; mode++)
+    {
+        if (0 == strcmp(aName, cModeNames[mode]))
+        {
+            aOutMode = static_cast<ProfileMode>(mode);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* Profiler::GetZoneName(const ProfileZone aZone)
+{
+    return aZone >= 0 && aZone < PZ_COUNT ? cZoneNames[aZone] : "unknown";
+}
+
+void Profiler::AddSample(const ProfileZone aZone, const double aMicroseconds)
+{
+    ThreadProfile& profile(GetThreadProfile());
+
+    profile.m_turnTime[aZone] += aMicroseconds;
+    profile.m_runTime[aZone] += aMicroseconds;
+    profile.m_runCount[aZone]++;
+}
+
+void Profiler::EndTurn(const int aTurn)
+{
+    TurnProfile turn = {};
+
+    {
+        std::lock_guard<std::mutex> lock(s_threadsLock);
+
+        for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+        {
+            for (int zone = 0; zone < PZ_COUNT; zone++)
+            {
+                turn.m_time[zone] += profile->m_turnTime[zone];
+                profile->m_turnTime[zone] = 0.0;
+            }
+        }
+    }
+
+    s_turns.push_back(turn);
+
+    if (PM_TURN == s_mode)
+    {
+        std::string line;
+
+        AppendTurnBreakdown(turn, PZ_TURN, line);
+        LOG_MESSAGE(LL_SUMMARY, "Profile turn %d (ms): %s\n", aTurn, line.c_str());
+    }
+}
+
+void Profiler::PrintSummary(void)
+{
+    std::lock_guard<std::mutex> lock(s_threadsLock);
+
+    unsigned long long counts[PZ_COUNT] = {};
+    double targetingTime(0.0);
+
+    for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+    {
+        for (int zone = 0; zone < PZ_COUNT; zone++)
+        {
+            counts[zone] += profile->m_runCount[zone];
+        }
+
+        targetingTime += profile->m_runTime[PZ_TARGETING];
+    }
+
+    LOG_MESSAGE(LL_SUMMARY, "Profile over %d turns, milliseconds per turn\n", static_cast<int>(s_turns.size()));
+    LOG_MESSAGE(LL_SUMMARY, "Profile %-20s %10s %12s %10s %10s %10s\n", "zone", "calls", "total", "min", "mean", "p99");
+    PrintZoneSummary(PZ_TURN, 0, counts);
+
+    /* Share of the targeting wall time each thread spent finding targets. Threads are numbered in the
+    order they first reported; the thread running the turn only shows up here when jobs run inline */
+    int thread(0);
+    double busyTime(0.0);
+    int numberOfThreads(0);
+
+    for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+    {
+        if (0 < profile->m_runCount[PZ_FIND_TARGETS] || 0 < profile->m_runCount[PZ_WORKER_WAKEUP])
+        {
+            LOG_MESSAGE(LL_SUMMARY, "Profile thread %d: %llu chunks, %.3f ms finding targets, %.1f%% of targeting\n", thread,
+                profile->m_runCount[PZ_FIND_TARGETS], profile->m_runTime[PZ_FIND_TARGETS] / 1000.0,
+                targetingTime > 0.0 ? 100.0 * profile->m_runTime[PZ_FIND_TARGETS] / targetingTime : 0.0);
+
+            busyTime += profile->m_runTime[PZ_FIND_TARGETS];
+            numberOfThreads++;
+            thread++;
+        }
+    }
+
+    if (0 < numberOfThreads && targetingTime > 0.0)
+    {
+        LOG_MESSAGE(LL_SUMMARY, "Profile thread utilization while targeting: %.1f%% over %d threads\n",
+            100.0 * busyTime / (targetingTime * numberOfThreads), numberOfThreads);
+    }
+}
+
+void Profiler::Reset(void)
+{
+    std::lock_guard<std::mutex> lock(s_threadsLock);
+
+    for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+    {
+        memset(profile.get(), 0, sizeof(ThreadProfile));
+    }
+
+    s_turns.clear();
+}
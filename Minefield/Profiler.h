@@ -0,0 +1,121 @@
+#pragma once
+
+#include "QueryPerformanceTimer.h"
+
+/// <summary>
+/// Timed sections of a turn. Each zone sits below its parent in reports; zones run by workers add up
+/// the time of every thread, so together they may exceed the wall time of their parent.
+/// </summary>
+enum ProfileZone
+{
+    PZ_TURN = 0,
+    PZ_PREPARE_TARGETING,   // Turn: spatial index refresh and retarget queue
+    PZ_TARGETING,           // Turn: whole ParallelFor, as seen by the calling thread
+    PZ_WORKER_WAKEUP,       // Targeting: from job dispatch until a worker starts on it
+    PZ_FIND_TARGETS,        // Targeting: FindCurrentTargets over a chunk of the retarget queue
+    PZ_SELECTION,           // Turn: GetObjectWithMostEnemyTargets
+    PZ_EXPLOSION,           // Turn: Explode
+    PZ_CHAIN_REACTION,      // Explosion: damage propagation
+    PZ_REMOVAL,             // Explosion: removing exploded mines
+    PZ_COUNT
+};
+
+/* How much the profiler records and reports */
+enum ProfileMode
+{
+    PM_OFF = 0,
+    /* End of run summary */
+    PM_SUMMARY,
+    /* Plus one breakdown line per turn */
+    PM_TURN
+};
+
+/// <summary>
+/// Per turn profiler. Zones are timed by ProfileScope into a buffer owned by the calling thread, so
+/// threads never share a counter. Once a turn is over, EndTurn folds every thread buffer into that
+/// turn record; PrintSummary reports min, mean and 99th percentile per turn of every zone, and how
+/// busy each thread was while targeting. While off, a scope costs a single load and compare.
+/// </summary>
+class Profiler
+{
+public:
+    /// <summary>
+    /// Sets what is recorded. Change it only while no zone is open. PM_OFF by default.
+    /// </summary>
+    /// <param name="aMode">ProfileMode. Mode</param>
+    static void SetMode(const ProfileMode aMode) { s_mode = aMode; }
+    /// <summary>
+    /// Returns what is recorded.
+    /// </summary>
+    /// <returns>ProfileMode. Mode</returns>
+    static ProfileMode GetMode(void) { return s_mode; }
+    /// <summary>
+    /// Whether zones are recorded.
+    /// </summary>
+    /// <returns>bool. True unless off</returns>
+    static bool IsEnabled(void) { return PM_OFF != s_mode; }
+    /// <summary>
+    /// Parses mode name (off, summary, turn).
+    /// </summary>
+    /// <param name="aName">const char*. Name to parse</param>
+    /// <param name="aOutMode">ProfileMode&. Parsed mode</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseMode(const char* aName, ProfileMode& aOutMode);
+    /// <summary>
+    /// Returns printable zone name.
+    /// </summary>
+    /// <param name="aZone">ProfileZone. Zone</param>
+    /// <returns>const char*. Name</returns>
+    static const char* GetZoneName(const ProfileZone aZone);
+    /// <summary>
+    /// Adds time spent in a zone to the calling thread buffer.
+    /// </summary>
+    /// <param name="aZone">ProfileZone. Zone</param>
+    /// <param name="aMicroseconds">double. Time spent</param>
+    static void AddSample(const ProfileZone aZone, const double aMicroseconds);
+    /// <summary>
+    /// Closes a turn: folds every thread buffer into a turn record and, in PM_TURN mode, logs its
+    /// breakdown. Call from the thread running the turn, while workers are idle.
+    /// </summary>
+    /// <param name="aTurn">int. Turn number</param>
+    static void EndTurn(const int aTurn);
+    /// <summary>
+    /// Logs per zone statistics over every turn closed so far, then thread utilization.
+    /// </summary>
+    static void PrintSummary(void);
+    /// <summary>
+    /// Drops every turn recorded.
+    /// </summary>
+    static void Reset(void);
+
+private:
+    static ProfileMode s_mode;
+};
+
+/// <summary>
+/// Times the enclosing scope into a zone. Scopes nest freely, each one reports to its own zone.
+/// </summary>
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const ProfileZone aZone) :
+        m_zone(aZone),
+        m_start(Profiler::IsEnabled() ? QueryPerformanceTimer::Now() : 0.0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (Profiler::IsEnabled())
+        {
+            Profiler::AddSample(m_zone, QueryPerformanceTimer::Now() - m_start);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const ProfileZone m_zone;
+    const double m_start;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifdef _WIN32
+#include "Windows.h"
+#elif __linux
+#include <time.h>
+#endif
+
+/// <summary>
+/// High resolution stopwatch. Get returns microseconds elapsed since Start or the previous Get on every platform.
+/// </summary>
+class QueryPerformanceTimer
+{
+public:
+    QueryPerformanceTimer() : m_start(0.0), m_stop(0.0)
+    {
+    }
+
+    void Start()
+    {
+        m_start = Now();
+    }
+
+    double Get()
+    {
+        m_stop = Now();
+
+        double time = m_stop - m_start;
+
+        m_start = m_stop;
+
+        // time value is in micro seconds
+        return time;
+    }
+
+    /// <summary>
+    /// Returns current time of the monotonic clock, comparable across threads.
+    /// </summary>
+    /// <returns>double. Microseconds since an arbitrary point</returns>
+#ifdef _WIN32
+    static double Now()
+    {
+        static const double s_inverseFrequency(GetInverseFrequency());
+
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+
+        return (double)counter.QuadPart * s_inverseFrequency;
+    }
+#elif __linux
+    static double Now()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+    }
+#endif
+
+    double m_start;
+    double m_stop;
+
+private:
+#ifdef _WIN32
+    static double GetInverseFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        return 1000000.0 / (double)frequency.QuadPart;
+    }
+#endif
+};
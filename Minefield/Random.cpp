@@ -3,12 +3,19 @@
 #include <random>
 
 static std::mt19937 s_mersenneTwisterRand(std::mt19937::default_seed);
+static unsigned int s_seed(std::mt19937::default_seed);
 
 void SetRandomSeed(const unsigned int aSeed)
 {
+    s_seed = aSeed;
     s_mersenneTwisterRand.seed(static_cast<std::mt19937::result_type>(aSeed));
 }
 
+unsigned int GetRandomSeed()
+{
+    return s_seed;
+}
+
 unsigned int GetRandomUInt32()
 {
     return s_mersenneTwisterRand();
@@ -24,3 +31,14 @@ float GetRandomFloat32_Range(float aMin, float aMax)
     unsigned int randomValue = GetRandomUInt32();
     return aMin + (static_cast<float>(randomValue) * (aMax - aMin) / 4294967295.0f);
 }
+
+void DrawRandomFloat32_Range(const unsigned int aSeed, const float aMin, const float aMax, float* aOut, const int aCount)
+{
+    std::mt19937 mersenneTwisterRand(static_cast<std::mt19937::result_type>(aSeed));
+
+    for (int i = 0; i < aCount; i++)
+    {
+        unsigned int randomValue = mersenneTwisterRand();
+        aOut[i] = aMin + (static_cast<float>(randomValue) * (aMax - aMin) / 4294967295.0f);
+    }
+}
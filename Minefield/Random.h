@@ -7,3 +7,77 @@ unsigned int GetRandomUInt32();
 float GetRandomFloat32();
 
 float GetRandomFloat32_Range(float aMin, float aMax);
+
+/// <summary>
+/// Fills aOut with the draws GetRandomFloat32_Range would return first after SetRandomSeed(aSeed), from a
+/// generator of its own, so games played side by side with different seeds do not share one.
+/// </summary>
+/// <param name="aSeed">unsigned int. Seed</param>
+/// <param name="aMin">float. Minimum value</param>
+/// <param name="aMax">float. Maximum value</param>
+/// <param name="aOut">float*. Output values</param>
+/// <param name="aCount">int. Number of draws</param>
+void DrawRandomFloat32_Range(const unsigned int aSeed, const float aMin, const float aMax, float* aOut, const int aCount);
+
+/// <summary>
+/// Returns seed last given to SetRandomSeed, the key of the counter based generator below.
+/// </summary>
+/// <returns>unsigned int. Seed</returns>
+unsigned int GetRandomSeed();
+
+/* First counter word values reserved for setup draws, so they never meet a targeting pass number */
+enum RandomStream : unsigned int
+{
+    RS_SPAWN_OBJECT_ID = 0xFFFFFF00u,
+    RS_SPAWN_POSITION,
+    RS_SPAWN_PROPERTIES
+};
+
+/// <summary>
+/// Philox4x32-10 counter based generator: a pure function of key and counter, so it keeps no state,
+/// any thread can draw from it at any time, and a given draw does not depend on which thread makes
+/// it or in which order. Second key word and fourth counter word are 0; first output word only.
+/// </summary>
+/// <param name="aKey">unsigned int. First key word, normally the run seed</param>
+/// <param name="aCounter0">unsigned int. First counter word; counter words are whatever identifies the draw</param>
+/// <param name="aCounter1">unsigned int. Second counter word</param>
+/// <param name="aCounter2">unsigned int. Third counter word</param>
+/// <returns>unsigned int. Random value</returns>
+constexpr unsigned int GetCounterRandomUInt32(const unsigned int aKey, const unsigned int aCounter0, const unsigned int aCounter1, const unsigned int aCounter2)
+{
+    const unsigned long long cMultiplier0 = 0xD2511F53ull;
+    const unsigned long long cMultiplier1 = 0xCD9E8D57ull;
+
+    unsigned int c0(aCounter0), c1(aCounter1), c2(aCounter2), c3(0);
+    unsigned int k0(aKey), k1(0);
+
+    for (int round = 0; round < 10; ++round)
+    {
+        const unsigned long long product0(cMultiplier0 * c0);
+        const unsigned long long product1(cMultiplier1 * c2);
+
+        c0 = static_cast<unsigned int>(product1 >> 32) ^ c1 ^ k0;
+        c1 = static_cast<unsigned int>(product1);
+        c2 = static_cast<unsigned int>(product0 >> 32) ^ c3 ^ k1;
+        c3 = static_cast<unsigned int>(product0);
+
+        /* Weyl sequence key schedule */
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    return c0;
+}
+
+/* Known answer, zero key and counter, from the Random123 Philox4x32-10 test vectors */
+static_assert(0x6627E8D5u == GetCounterRandomUInt32(0, 0, 0, 0), "GetCounterRandomUInt32 is not Philox4x32-10");
+
+/// <summary>
+/// Counter based float in [0, 1). See GetCounterRandomUInt32.
+/// </summary>
+/// <returns>float. Random value</returns>
+inline float GetCounterRandomFloat32(const unsigned int aKey, const unsigned int aCounter0, const unsigned int aCounter1, const unsigned int aCounter2)
+{
+    /* 24 bits, exactly what a float mantissa holds */
+    return static_cast<float>(GetCounterRandomUInt32(aKey, aCounter0, aCounter1, aCounter2) >> 8) * (1.0f / 16777216.0f);
+}
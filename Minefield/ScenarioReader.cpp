@@ -0,0 +1,400 @@
+#include "stdafx.h"
+#include "ScenarioReader.h"
+#include "Mine.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char ScenarioReader::cBinaryMagic[8] = { 'M', 'I', 'N', 'E', 'L', 'I', 'S', 'T' };
+
+namespace
+{
+    /* Status of entries that are not records at all: blank lines, comments, CSV header */
+    const int cNotARecord = -1;
+    /* Smallest binary record this version understands, larger ones carry fields appended later */
+    const size_t cMinBinaryRecordSize = 28;
+
+    /// <summary>
+    /// Parses one CSV field with aParse (a strto* wrapper) and steps past its separator.
+    /// </summary>
+    template<typename TValue, typename TParse>
+    bool ParseField(const char*& aCursor, const char* aLineEnd, const bool aLast, TValue& aOut, TParse aParse)
+    {
+        char* pEnd(NULL);
+
+        aOut = aParse(aCursor, &pEnd);
+
+        if (pEnd == aCursor || pEnd > aLineEnd)
+        {
+            return false;
+        }
+
+        while (pEnd < aLineEnd && isspace(static_cast<unsigned char>(*pEnd)))
+        {
+            pEnd++;
+        }
+
+        if (aLast)
+        {
+            return pEnd == aLineEnd;
+        }
+        if (pEnd == aLineEnd || ',' != *pEnd)
+        {
+            return false;
+        }
+
+        aCursor = pEnd + 1;
+        return true;
+    }
+
+    /// <summary>
+    /// Checks values that do not depend on other records. Radii past cMaxDestructiveRadius would escape
+    /// the neighbourhood incremental retargeting and shard ghosts cover.
+    /// </summary>
+    int ValidateRecord(const MineRecord& aRecord, const int aNumberOfTeams)
+    {
+        if (!std::isfinite(aRecord.m_position.x) || !std::isfinite(aRecord.m_position.y) || !std::isfinite(aRecord.m_position.z) ||
+            !(aRecord.m_destructiveRadius >= cMinDestructiveRadius && aRecord.m_destructiveRadius <= cMaxDestructiveRadius))
+        {
+            return SE_BAD_VALUE;
+        }
+        if (aRecord.m_team < 0 || aRecord.m_team >= aNumberOfTeams)
+        {
+            return SE_TEAM_OUT_OF_RANGE;
+        }
+
+        return SE_COUNT;
+    }
+
+    /// <summary>
+    /// Parses CSV line [aBegin, aLineEnd), returns its status.
+    /// </summary>
+    int ParseCsvLine(const char* aBegin, const char* aLineEnd, const bool aFirstLine, const int aNumberOfTeams, MineRecord& aOut)
+    {
+        while (aBegin < aLineEnd && isspace(static_cast<unsigned char>(*aBegin)))
+        {
+            aBegin++;
+        }
+
+        if (aBegin == aLineEnd || '#' == *aBegin || (aFirstLine && isalpha(static_cast<unsigned char>(*aBegin))))
+        {
+            return cNotARecord;
+        }
+        if (!isdigit(static_cast<unsigned char>(*aBegin)))
+        {
+            return SE_MALFORMED;
+        }
+
+        const auto parseUnsigned = [](const char* aText, char** apEnd) { return strtoul(aText, apEnd, 10); };
+        const auto parseSigned = [](const char* aText, char** apEnd) { return strtol(aText, apEnd, 10); };
+        const auto parseFloat = [](const char* aText, char** apEnd) { return strtof(aText, apEnd); };
+
+        const char* cursor(aBegin);
+        unsigned long objectId(0);
+        long team(0), active(0), invulnerable(0);
+
+        const bool parsed(ParseField(cursor, aLineEnd, false, objectId, parseUnsigned) &&
+                          ParseField(cursor, aLineEnd, false, team, parseSigned) &&
+                          ParseField(cursor, aLineEnd, false, aOut.m_position.x, parseFloat) &&
+                          ParseField(cursor, aLineEnd, false, aOut.m_position.y, parseFloat) &&
+                          ParseField(cursor, aLineEnd, false, aOut.m_position.z, parseFloat) &&
+                          ParseField(cursor, aLineEnd, false, aOut.m_destructiveRadius, parseFloat) &&
+                          ParseField(cursor, aLineEnd, false, active, parseSigned) &&
+                          ParseField(cursor, aLineEnd, true, invulnerable, parseSigned));
+
+        if (!parsed || objectId > 0xFFFFFFFFul || (0 != active && 1 != active) || (0 != invulnerable && 1 != invulnerable))
+        {
+            return SE_MALFORMED;
+        }
+
+        aOut.m_objectId = static_cast<unsigned int>(objectId);
+        aOut.m_team = team < INT32_MIN || team > INT32_MAX ? -1 : static_cast<int>(team);
+        aOut.m_bitFlags = (active ? Mine::OBF_ACTIVE : 0) | (invulnerable ? Mine::OBF_INVULNERABLE : 0);
+
+        return ValidateRecord(aOut, aNumberOfTeams);
+    }
+}
+
+ScenarioReader::ScenarioReader(MineManager& aManager, const int aNumberOfTeams) :
+    m_manager(aManager)
+  , m_numberOfTeams(aNumberOfTeams)
+  , m_pFile(NULL)
+  , m_recordSize(0)
+  , m_numberName("line")
+  , m_numberOfMinesAdded(0)
+{
+    memset(m_numberOfErrors, 0, sizeof(m_numberOfErrors));
+}
+
+ScenarioReader::~ScenarioReader()
+{
+    if (NULL != m_pFile)
+    {
+        fclose(m_pFile);
+    }
+}
+
+bool ScenarioReader::Open(const char* aPath)
+{
+    m_pFile = fopen(aPath, "rb");
+
+    if (NULL == m_pFile)
+    {
+        m_errorMessages.push_back("cannot open file");
+        return false;
+    }
+
+    m_buffer.resize(sizeof(cBinaryMagic));
+    m_buffer.resize(fread(m_buffer.data(), 1, m_buffer.size(), m_pFile));
+
+    if (m_buffer.size() == sizeof(cBinaryMagic) && 0 == memcmp(m_buffer.data(), cBinaryMagic, sizeof(cBinaryMagic)))
+    {
+        uint32_t version(0), recordSize(0);
+
+        m_buffer.clear();
+
+        if (1 != fread(&version, sizeof(version), 1, m_pFile) || 1 != fread(&recordSize, sizeof(recordSize), 1, m_pFile))
+        {
+            m_errorMessages.push_back("binary header is truncated");
+            return false;
+        }
+        if (cBinaryVersion != version || recordSize < cMinBinaryRecordSize)
+        {
+            m_errorMessages.push_back("unsupported binary version or record size");
+            return false;
+        }
+
+        m_recordSize = recordSize;
+        m_numberName = "record";
+    }
+
+    return true;
+}
+
+void ScenarioReader::Read(WorkerPool& aPool)
+{
+    if (NULL != m_pFile)
+    {
+        if (0 != m_recordSize)
+        {
+            ReadBinary(aPool);
+        }
+        else
+        {
+            ReadCsv(aPool);
+        }
+
+        fclose(m_pFile);
+        m_pFile = NULL;
+    }
+}
+
+const char* ScenarioReader::GetErrorName(const ScenarioError aError)
+{
+    switch (aError)
+    {
+    case SE_MALFORMED:
+        return "malformed";
+    case SE_BAD_VALUE:
+        return "invalid position or radius";
+    case SE_TEAM_OUT_OF_RANGE:
+        return "team out of range";
+    case SE_DUPLICATE_ID:
+        return "duplicate object id";
+    default:
+        return "unknown";
+    }
+}
+
+void ScenarioReader::ReadCsv(WorkerPool& aPool)
+{
+    std::vector<char>& buffer(m_buffer);
+
+    /* Capacity grows only if a single line does not fit; one spare byte terminates the chunk */
+    size_t capacity(cChunkSize);
+    size_t filled(buffer.size());
+    bool endOfFile(false);
+    long long firstLine(1);
+
+    buffer.resize(capacity + 1);
+
+    for (;;)
+    {
+        if (!endOfFile)
+        {
+            const size_t requested(capacity - filled);
+            const size_t read(fread(buffer.data() + filled, 1, requested, m_pFile));
+
+            filled += read;
+            endOfFile = read < requested;
+        }
+
+        if (0 == filled)
+        {
+            break;
+        }
+
+        /* Chunk ends after its last complete line, the partial one is carried over */
+        size_t end(filled);
+
+        if (!endOfFile)
+        {
+            while (end > 0 && '\n' != buffer[end - 1])
+            {
+                end--;
+            }
+
+            if (0 == end)
+            {
+                capacity *= 2;
+                buffer.resize(capacity + 1);
+                continue;
+            }
+        }
+
+        m_lineStarts.clear();
+
+        for (size_t start = 0; start < end;)
+        {
+            m_lineStarts.push_back(start);
+
+            const char* pNewLine(static_cast<const char*>(memchr(buffer.data() + start, '\n', end - start)));
+
+            start = NULL != pNewLine ? static_cast<size_t>(pNewLine - buffer.data()) + 1 : end;
+        }
+
+        const int numberOfLines(static_cast<int>(m_lineStarts.size()));
+        const char saved(buffer[end]);
+
+        /* strto* stop at the terminator on the last line of the chunk */
+        buffer[end] = '\0';
+        m_records.resize(numberOfLines);
+        m_status.resize(numberOfLines);
+
+        aPool.ParallelFor(numberOfLines, [this, &buffer, end, firstLine](int aBegin, int aEnd, int)
+        {
+            for (int i = aBegin; i < aEnd; ++i)
+            {
+                const char* pLine(buffer.data() + m_lineStarts[i]);
+                const char* pLineEnd(buffer.data() + (i + 1 < static_cast<int>(m_lineStarts.size()) ? m_lineStarts[i + 1] : end));
+
+                m_status[i] = ParseCsvLine(pLine, pLineEnd, 1 == firstLine + i, m_numberOfTeams, m_records[i]);
+            }
+        });
+
+        buffer[end] = saved;
+
+        Feed(firstLine);
+
+        firstLine += numberOfLines;
+        memmove(buffer.data(), buffer.data() + end, filled - end);
+        filled -= end;
+    }
+}
+
+void ScenarioReader::ReadBinary(WorkerPool& aPool)
+{
+    std::vector<char>& buffer(m_buffer);
+    const size_t recordSize(m_recordSize);
+    const size_t recordsPerChunk(std::max<size_t>(cChunkSize / recordSize, 1));
+    long long firstRecord(1);
+
+    buffer.resize(recordsPerChunk * recordSize);
+
+    for (;;)
+    {
+        const size_t read(fread(buffer.data(), 1, buffer.size(), m_pFile));
+        const int numberOfRecords(static_cast<int>(read / recordSize));
+
+        m_records.resize(numberOfRecords);
+        m_status.resize(numberOfRecords);
+
+        aPool.ParallelFor(numberOfRecords, [this, &buffer, recordSize](int aBegin, int aEnd, int)
+        {
+            for (int i = aBegin; i < aEnd; ++i)
+            {
+                const char* pRecord(buffer.data() + i * recordSize);
+                MineRecord& record(m_records[i]);
+
+                memcpy(&record.m_objectId, pRecord, 4);
+                memcpy(&record.m_team, pRecord + 4, 4);
+                memcpy(&record.m_position.x, pRecord + 8, 4);
+                memcpy(&record.m_position.y, pRecord + 12, 4);
+                memcpy(&record.m_position.z, pRecord + 16, 4);
+                memcpy(&record.m_destructiveRadius, pRecord + 20, 4);
+                record.m_bitFlags = static_cast<unsigned char>(pRecord[24]) & (Mine::OBF_ACTIVE | Mine::OBF_INVULNERABLE);
+
+                m_status[i] = ValidateRecord(record, m_numberOfTeams);
+            }
+        });
+
+        Feed(firstRecord);
+
+        firstRecord += numberOfRecords;
+
+        if (read < buffer.size())
+        {
+            if (0 != read % recordSize)
+            {
+                ReportError(SE_MALFORMED, firstRecord, 0);
+            }
+
+            break;
+        }
+    }
+}
+
+void ScenarioReader::Feed(const long long aFirstNumber)
+{
+    m_accepted.clear();
+    m_chunkIds.clear();
+
+    for (int i = 0; i < static_cast<int>(m_records.size()); ++i)
+    {
+        const MineRecord& record(m_records[i]);
+
+        if (cNotARecord == m_status[i])
+        {
+            continue;
+        }
+        if (SE_COUNT != m_status[i])
+        {
+            ReportError(static_cast<ScenarioError>(m_status[i]), aFirstNumber + i, record.m_objectId);
+        }
+        else if (!m_chunkIds.insert(record.m_objectId).second || NULL != m_manager.GetObjectByID(record.m_objectId))
+        {
+            ReportError(SE_DUPLICATE_ID, aFirstNumber + i, record.m_objectId);
+        }
+        else
+        {
+            m_accepted.push_back(record);
+        }
+    }
+
+    m_numberOfMinesAdded += m_manager.AddMineRecords(m_accepted.data(), static_cast<int>(m_accepted.size()));
+}
+
+void ScenarioReader::ReportError(const ScenarioError aError, const long long aNumber, const unsigned int aObjectId)
+{
+    m_numberOfErrors[aError]++;
+
+    if (static_cast<int>(m_errorMessages.size()) < cMaxErrorMessages)
+    {
+        char message[128];
+
+        if (SE_MALFORMED == aError)
+        {
+            snprintf(message, sizeof(message), "%s %lld: %s", m_numberName, aNumber, GetErrorName(aError));
+        }
+        else
+        {
+            snprintf(message, sizeof(message), "%s %lld: %s (object id %u)", m_numberName, aNumber, GetErrorName(aError), aObjectId);
+        }
+
+        m_errorMessages.push_back(message);
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "MineManager.h"
+#include <stdio.h>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class WorkerPool;
+
+/// <summary>
+/// Problems found in scenario records. Offending records are skipped, the rest of the file is still read.
+/// </summary>
+enum ScenarioError
+{
+    /* Not the expected number of fields, or a field is not a number */
+    SE_MALFORMED = 0,
+    /* Position not finite, or radius outside [cMinDestructiveRadius, cMaxDestructiveRadius] */
+    SE_BAD_VALUE,
+    SE_TEAM_OUT_OF_RANGE,
+    /* Object ID already used by an earlier record */
+    SE_DUPLICATE_ID,
+    SE_COUNT
+};
+
+/// <summary>
+/// Streams a mine list into MineManager. Two formats are accepted, told apart by their first bytes:
+/// - CSV, one mine per line: id,team,x,y,z,radius,active,invulnerable (last two 0 or 1). Empty lines,
+///   lines starting with '#' and a header line starting with a letter are ignored.
+/// - Binary: cBinaryMagic, then uint32 version and record size, then packed little endian records of
+///   uint32 id, int32 team, float x, y, z, radius, uint8 flags (Mine::ObjectBitFlags) and 3 padding bytes.
+/// The file is read cRecordChunkSize bytes at a time. Each chunk is parsed on the worker pool, validated in
+/// file order and handed to MineManager before the next one is read, so memory stays bounded whatever
+/// the file size.
+/// </summary>
+class ScenarioReader
+{
+public:
+    static const char cBinaryMagic[8];
+    static const unsigned int cBinaryVersion = 1;
+    static const size_t cChunkSize = 4 << 20;
+    /* Error messages kept for GetErrorMessages, errors past this are only counted */
+    static const int cMaxErrorMessages = 20;
+
+    /// <summary>
+    /// Reader feeding aManager, accepting teams in [0, aNumberOfTeams).
+    /// </summary>
+    ScenarioReader(MineManager& aManager, const int aNumberOfTeams);
+    ~ScenarioReader(void);
+
+    ScenarioReader(const ScenarioReader&) = delete;
+    ScenarioReader& operator=(const ScenarioReader&) = delete;
+
+    /// <summary>
+    /// Opens a scenario file and works out its format.
+    /// </summary>
+    /// <param name="aPath">const char*. File path</param>
+    /// <returns>bool. False if the file cannot be read at all (missing, unknown binary version), see
+    /// GetErrorMessages</returns>
+    bool Open(const char* aPath);
+    /// <summary>
+    /// Streams every mine of the open file into MineManager, then closes it. Invalid records do not stop
+    /// the read, see GetNumberOfErrors.
+    /// </summary>
+    /// <param name="aPool">WorkerPool&. Pool to parse on</param>
+    void Read(WorkerPool& aPool);
+
+    /// <summary>
+    /// Returns number of mines handed to MineManager so far.
+    /// </summary>
+    /// <returns>long long. Number of mines</returns>
+    inline long long GetNumberOfMinesAdded(void) const { return m_numberOfMinesAdded; }
+    /// <summary>
+    /// Returns number of records skipped because of an error.
+    /// </summary>
+    /// <param name="aError">ScenarioError. Error kind</param>
+    /// <returns>long long. Number of records</returns>
+    inline long long GetNumberOfErrors(const ScenarioError aError) const { return m_numberOfErrors[aError]; }
+    /// <summary>
+    /// Returns description of the first cMaxErrorMessages errors, or why Read failed.
+    /// </summary>
+    /// <returns>const std::vector<std::string>&. Messages, "line 12: ..." or "record 12: ..."</returns>
+    inline const std::vector<std::string>& GetErrorMessages(void) const { return m_errorMessages; }
+    /// <summary>
+    /// Returns printable error kind.
+    /// </summary>
+    /// <param name="aError">ScenarioError. Error kind</param>
+    /// <returns>const char*. Description</returns>
+    static const char* GetErrorName(const ScenarioError aError);
+
+private:
+    /// <summary>
+    /// Reads CSV lines from the current position on. m_buffer holds bytes already read.
+    /// </summary>
+    void ReadCsv(WorkerPool& aPool);
+    /// <summary>
+    /// Reads binary records from the current position on, past the header.
+    /// </summary>
+    void ReadBinary(WorkerPool& aPool);
+    /// <summary>
+    /// Validates parsed records in file order and adds the good ones.
+    /// </summary>
+    /// <param name="aFirstNumber">long long. Line or record number of the first entry</param>
+    void Feed(const long long aFirstNumber);
+    /// <summary>
+    /// Counts an error, keeping its message if there is room.
+    /// </summary>
+    void ReportError(const ScenarioError aError, const long long aNumber, const unsigned int aObjectId);
+
+    MineManager& m_manager;
+    const int m_numberOfTeams;
+    FILE* m_pFile;
+    /* Binary record size, 0 for CSV */
+    size_t m_recordSize;
+    std::vector<char> m_buffer;
+    /* "line" for CSV, "record" for binary */
+    const char* m_numberName;
+    long long m_numberOfMinesAdded;
+    long long m_numberOfErrors[SE_COUNT];
+    std::vector<std::string> m_errorMessages;
+    /* Current chunk: parsed records, parse outcome of each (SE_COUNT when fine, -1 when blank), and
+    where each CSV line starts */
+    std::vector<MineRecord> m_records;
+    std::vector<int> m_status;
+    std::vector<size_t> m_lineStarts;
+    std::vector<MineRecord> m_accepted;
+    /* IDs accepted from the current chunk, not yet visible through MineManager */
+    std::unordered_set<unsigned int> m_chunkIds;
+};
@@ -0,0 +1,787 @@
+#include "stdafx.h"
+#include "ShardedSimulation.h"
+#include "MineManager.h"
+#include "Mine.h"
+#include "Logger.h"
+#include "WorkerPool.h"
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#ifdef __linux
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#endif
+
+namespace
+{
+    /* Turn reports stop after the first few turns, as in Simulation */
+    const int cNumberOfReportedTurns = 4;
+
+    /* Coordinator requests; every one is answered by a single SM_REPLY */
+    enum ShardMessage
+    {
+        /* Argument: unused. Payload: IDs of ghosts to drop before targeting */
+        SM_TARGET = 0,
+        /* Argument: team. Reply: ShardBest */
+        SM_SELECT,
+        /* Argument: object ID. Reply: ShardDamage list */
+        SM_EXPLODE,
+        /* Payload: MineDamage list. Reply: ShardDamage list */
+        SM_DAMAGE,
+        /* Reply: ShardRemoval list */
+        SM_END_TURN,
+        /* Reply: owned, ghosts, dropped, then owned mines of every team */
+        SM_RESULTS,
+        SM_QUIT,
+        SM_REPLY
+    };
+
+    struct MessageHeader
+    {
+        int m_type;
+        int m_argument;
+        /* Payload size, bytes */
+        int m_size;
+    };
+
+    /// <summary>
+    /// Best mine of a team within one shard.
+    /// </summary>
+    struct ShardBest
+    {
+        int m_numberOfTargets;
+        unsigned int m_objectId;
+    };
+
+    /// <summary>
+    /// Damage dealt to a ghost, with the shard owning it.
+    /// </summary>
+    struct ShardDamage
+    {
+        int m_shard;
+        MineDamage m_damage;
+    };
+
+    /// <summary>
+    /// Mine destroyed this turn, to be dropped by a shard holding it as a ghost.
+    /// </summary>
+    struct ShardRemoval
+    {
+        int m_shard;
+        unsigned int m_objectId;
+    };
+
+    /// <summary>
+    /// Slab layout: equal slabs over the spawn extent, the outer ones reaching to infinity so nothing
+    /// spawned outside of it is lost.
+    /// </summary>
+    struct SlabLayout
+    {
+        SlabLayout(const int aNumberOfShards, const float aExtent) :
+            m_numberOfShards(aNumberOfShards),
+            m_extent(aExtent),
+            m_width(2.0f * aExtent / aNumberOfShards)
+        {
+        }
+
+        int GetShard(const float aX) const
+        {
+            const int shard(static_cast<int>(floorf((aX + m_extent) / m_width)));
+
+            return std::max(0, std::min(m_numberOfShards - 1, shard));
+        }
+
+        float GetBegin(const int aShard) const
+        {
+            return 0 == aShard ? -std::numeric_limits<float>::infinity() : -m_extent + aShard * m_width;
+        }
+
+        float GetEnd(const int aShard) const
+        {
+            return m_numberOfShards - 1 == aShard ? std::numeric_limits<float>::infinity() : -m_extent + (aShard + 1) * m_width;
+        }
+
+        /// <summary>
+        /// Whether aShard keeps a ghost of a mine at aX owned by another shard: any mine within reach of
+        /// its own ones may be one of their targets.
+        /// </summary>
+        bool IsGhostOf(const int aShard, const float aX) const
+        {
+            return GetShard(aX) != aShard && aX >= GetBegin(aShard) - cMaxDestructiveRadius && aX < GetEnd(aShard) + cMaxDestructiveRadius;
+        }
+
+        /// <summary>
+        /// Shards that may own or keep a ghost of a mine at aX, so IsGhostOf only needs testing on the
+        /// neighbours. Widened by one on each side, slab edges are rounded differently from GetShard.
+        /// </summary>
+        void GetReach(const float aX, int& aFirstShard, int& aLastShard) const
+        {
+            aFirstShard = std::max(0, GetShard(aX - cMaxDestructiveRadius) - 1);
+            aLastShard = std::min(m_numberOfShards - 1, GetShard(aX + cMaxDestructiveRadius) + 1);
+        }
+
+        int m_numberOfShards;
+        float m_extent;
+        float m_width;
+    };
+
+#ifdef __linux
+    bool WriteAll(const int aSocket, const void* aData, size_t aSize)
+    {
+        const char* pData(static_cast<const char*>(aData));
+
+        while (aSize > 0)
+        {
+            /* A shard gone is reported as a failure, not as SIGPIPE */
+            const ssize_t written(send(aSocket, pData, aSize, MSG_NOSIGNAL));
+
+            if (written < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                return false;
+            }
+
+            pData += written;
+            aSize -= static_cast<size_t>(written);
+        }
+
+        return true;
+    }
+
+    bool ReadAll(const int aSocket, void* aData, size_t aSize)
+    {
+        char* pData(static_cast<char*>(aData));
+
+        while (aSize > 0)
+        {
+            const ssize_t received(recv(aSocket, pData, aSize, 0));
+
+            if (received < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            if (received <= 0)
+            {
+                return false;
+            }
+
+            pData += received;
+            aSize -= static_cast<size_t>(received);
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool SendMessage(const int aSocket, const ShardMessage aType, const int aArgument, const std::vector<T>& aPayload)
+    {
+        const MessageHeader header = { aType, aArgument, static_cast<int>(aPayload.size() * sizeof(T)) };
+
+        return WriteAll(aSocket, &header, sizeof(header)) && (aPayload.empty() || WriteAll(aSocket, aPayload.data(), header.m_size));
+    }
+
+    bool SendMessage(const int aSocket, const ShardMessage aType, const int aArgument)
+    {
+        return SendMessage(aSocket, aType, aArgument, std::vector<char>());
+    }
+
+    /// <summary>
+    /// Receives a message, its payload replacing aPayload.
+    /// </summary>
+    template <typename T>
+    bool ReceiveMessage(const int aSocket, MessageHeader& aHeader, std::vector<T>& aPayload)
+    {
+        if (!ReadAll(aSocket, &aHeader, sizeof(aHeader)) || aHeader.m_size < 0 || 0 != aHeader.m_size % sizeof(T))
+        {
+            return false;
+        }
+
+        aPayload.resize(aHeader.m_size / sizeof(T));
+
+        return aPayload.empty() || ReadAll(aSocket, aPayload.data(), aHeader.m_size);
+    }
+
+    /// <summary>
+    /// Copies a payload received as bytes into entries of the type its message carries.
+    /// </summary>
+    template <typename T>
+    void DecodePayload(const std::vector<char>& aPayload, std::vector<T>& aOut)
+    {
+        aOut.resize(aPayload.size() / sizeof(T));
+
+        if (!aOut.empty())
+        {
+            memcpy(aOut.data(), aPayload.data(), aOut.size() * sizeof(T));
+        }
+    }
+
+    /// <summary>
+    /// Receives an SM_REPLY.
+    /// </summary>
+    template <typename T>
+    bool ReceiveReply(const int aSocket, std::vector<T>& aPayload)
+    {
+        MessageHeader header;
+
+        return ReceiveMessage(aSocket, header, aPayload) && SM_REPLY == header.m_type;
+    }
+#endif
+}
+
+ShardedSimulation::ShardedSimulation() :
+    m_numberOfTurns(0)
+{
+}
+
+ShardedSimulation::~ShardedSimulation()
+{
+    Stop();
+}
+
+bool ShardedSimulation::Fail(const char* aReason)
+{
+    m_error = aReason;
+    return false;
+}
+
+#ifdef __linux
+bool ShardedSimulation::Start(const ShardSettings& aSettings)
+{
+    Stop();
+
+    m_settings = aSettings;
+    m_numberOfTurns = 0;
+    m_pendingRemovals.assign(aSettings.m_numberOfShards, std::vector<unsigned int>());
+
+    if (aSettings.m_numberOfShards < 1)
+    {
+        return Fail("at least one shard is needed");
+    }
+
+    PartitionSpawns();
+
+    /* Children inherit whatever is still buffered */
+    fflush(stdout);
+
+    for (int shard = 0; shard < aSettings.m_numberOfShards; shard++)
+    {
+        int sockets[2];
+
+        if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+        {
+            Stop();
+            return Fail("cannot create shard socket");
+        }
+
+        const pid_t process(fork());
+
+        if (process < 0)
+        {
+            close(sockets[0]);
+            close(sockets[1]);
+            Stop();
+            return Fail("cannot fork shard process");
+        }
+
+        if (0 == process)
+        {
+            /* Earlier shards are none of this one's business */
+            for (const int socket : m_sockets)
+            {
+                close(socket);
+            }
+
+            close(sockets[0]);
+            RunShard(shard, sockets[1]);
+            _exit(0);
+        }
+
+        close(sockets[1]);
+        m_sockets.push_back(sockets[0]);
+        m_processes.push_back(process);
+    }
+
+    /* Shards have their copy */
+    std::vector<Vector3>().swap(m_spawnPositions);
+    std::vector<std::vector<unsigned int>>().swap(m_slabSpawns);
+
+    /* Every shard answers once its slab is built */
+    for (const int socket : m_sockets)
+    {
+        std::vector<char> payload;
+
+        if (!ReceiveReply(socket, payload))
+        {
+            Stop();
+            return Fail("shard failed to build its slab");
+        }
+    }
+
+    return true;
+}
+
+bool ShardedSimulation::RunTurn(bool& aTargetsFound)
+{
+    const int numberOfShards(static_cast<int>(m_sockets.size()));
+
+    aTargetsFound = false;
+    m_numberOfTurns++;
+
+    /* Shards target in parallel, every one dropping the ghosts destroyed last turn first */
+    for (int shard = 0; shard < numberOfShards; shard++)
+    {
+        if (!SendMessage(m_sockets[shard], SM_TARGET, 0, m_pendingRemovals[shard]))
+        {
+            return Fail("shard stopped answering");
+        }
+
+        m_pendingRemovals[shard].clear();
+    }
+
+    for (int shard = 0; shard < numberOfShards; shard++)
+    {
+        std::vector<char> payload;
+
+        if (!ReceiveReply(m_sockets[shard], payload))
+        {
+            return Fail("shard stopped answering");
+        }
+    }
+
+    std::vector<ShardDamage> damage;
+    std::vector<std::vector<MineDamage>> damagePerShard(numberOfShards);
+
+    for (int team = 0; team < m_settings.m_numberOfTeams; team++)
+    {
+        ShardBest best = { 0, 0 };
+        int bestShard(-1);
+
+        for (int shard = 0; shard < numberOfShards; shard++)
+        {
+            if (!SendMessage(m_sockets[shard], SM_SELECT, team))
+            {
+                return Fail("shard stopped answering");
+            }
+        }
+
+        for (int shard = 0; shard < numberOfShards; shard++)
+        {
+            std::vector<ShardBest> reply;
+
+            if (!ReceiveReply(m_sockets[shard], reply) || 1 != reply.size())
+            {
+                return Fail("shard stopped answering");
+            }
+
+            /* Same order a single ranking breaks ties in: most targets, then lowest object ID */
+            if (reply[0].m_numberOfTargets > best.m_numberOfTargets ||
+                (0 < reply[0].m_numberOfTargets && reply[0].m_numberOfTargets == best.m_numberOfTargets && reply[0].m_objectId < best.m_objectId))
+            {
+                best = reply[0];
+                bestShard = shard;
+            }
+        }
+
+        if (bestShard < 0)
+        {
+            continue;
+        }
+
+        if (!SendMessage(m_sockets[bestShard], SM_EXPLODE, static_cast<int>(best.m_objectId)) || !ReceiveReply(m_sockets[bestShard], damage))
+        {
+            return Fail("shard stopped answering");
+        }
+
+        /* Blasts reaching over a slab boundary are relayed to the owner, whose mines may go off in turn */
+        while (!damage.empty())
+        {
+            for (const ShardDamage& entry : damage)
+            {
+                damagePerShard[entry.m_shard].push_back(entry.m_damage);
+            }
+
+            damage.clear();
+
+            for (int shard = 0; shard < numberOfShards; shard++)
+            {
+                if (!damagePerShard[shard].empty() && !SendMessage(m_sockets[shard], SM_DAMAGE, 0, damagePerShard[shard]))
+                {
+                    return Fail("shard stopped answering");
+                }
+            }
+
+            for (int shard = 0; shard < numberOfShards; shard++)
+            {
+                std::vector<ShardDamage> reply;
+
+                if (damagePerShard[shard].empty())
+                {
+                    continue;
+                }
+                if (!ReceiveReply(m_sockets[shard], reply))
+                {
+                    return Fail("shard stopped answering");
+                }
+
+                damagePerShard[shard].clear();
+                damage.insert(damage.end(), reply.begin(), reply.end());
+            }
+        }
+
+        aTargetsFound = true;
+
+        if (cNumberOfReportedTurns >= m_numberOfTurns)
+        {
+            LOG_MESSAGE(LL_TURN, "Turn %d: Team %d picks Mine with object id %d (with %d targets) to explode\n", m_numberOfTurns, team,
+                best.m_objectId, best.m_numberOfTargets);
+        }
+    }
+
+    for (int shard = 0; shard < numberOfShards; shard++)
+    {
+        if (!SendMessage(m_sockets[shard], SM_END_TURN, 0))
+        {
+            return Fail("shard stopped answering");
+        }
+    }
+
+    for (int shard = 0; shard < numberOfShards; shard++)
+    {
+        std::vector<ShardRemoval> reply;
+
+        if (!ReceiveReply(m_sockets[shard], reply))
+        {
+            return Fail("shard stopped answering");
+        }
+
+        for (const ShardRemoval& removal : reply)
+        {
+            m_pendingRemovals[removal.m_shard].push_back(removal.m_objectId);
+        }
+    }
+
+    return true;
+}
+
+bool ShardedSimulation::GetResults(std::vector<ShardResult>& aResults)
+{
+    aResults.clear();
+
+    for (const int socket : m_sockets)
+    {
+        std::vector<int> reply;
+
+        if (!SendMessage(socket, SM_RESULTS, 0) || !ReceiveReply(socket, reply) || reply.size() != static_cast<size_t>(3 + m_settings.m_numberOfTeams))
+        {
+            return Fail("shard stopped answering");
+        }
+
+        ShardResult result;
+
+        result.m_numberOfMines = reply[0];
+        result.m_numberOfGhosts = reply[1];
+        result.m_numberOfMinesDropped = reply[2];
+        result.m_minesPerTeam.assign(reply.begin() + 3, reply.end());
+
+        aResults.push_back(result);
+    }
+
+    return true;
+}
+
+void ShardedSimulation::Stop(void)
+{
+    for (const int socket : m_sockets)
+    {
+        SendMessage(socket, SM_QUIT, 0);
+        close(socket);
+    }
+
+    for (const int process : m_processes)
+    {
+        waitpid(process, NULL, 0);
+    }
+
+    m_sockets.clear();
+    m_processes.clear();
+    std::vector<Vector3>().swap(m_spawnPositions);
+    std::vector<std::vector<unsigned int>>().swap(m_slabSpawns);
+}
+
+void ShardedSimulation::PartitionSpawns(void)
+{
+    const SlabLayout layout(m_settings.m_numberOfShards, Simulation::GetSpawnExtent(m_settings.m_distribution));
+    const int numberOfSpawns(m_settings.m_numberOfTeams * m_settings.m_numberOfMinesPerTeam);
+    std::vector<Vector3> clusterCenters;
+
+    Simulation::DrawClusterCenters(m_settings.m_randomSeed, m_settings.m_distribution, clusterCenters);
+    m_spawnPositions.resize(std::max(numberOfSpawns, 0));
+    m_slabSpawns.assign(m_settings.m_numberOfShards, std::vector<unsigned int>());
+
+    /* Positions are counter based, any thread can draw any of them. The pool is joined before forking */
+    WorkerPool workerPool;
+    workerPool.Start(m_settings.m_numberOfThreadsPerShard);
+    workerPool.ParallelFor(static_cast<int>(m_spawnPositions.size()), [this, &clusterCenters](int aBegin, int aEnd, int)
+    {
+        for (int i = aBegin; i < aEnd; ++i)
+        {
+            m_spawnPositions[i] = Simulation::GetSpawnPosition(m_settings.m_randomSeed, i, m_settings.m_distribution, clusterCenters);
+        }
+    });
+    workerPool.Stop();
+
+    /* Ascending ordinals, the order a single process spawns in */
+    for (int ordinal = 0; ordinal < numberOfSpawns; ordinal++)
+    {
+        const float x(m_spawnPositions[ordinal].x);
+        int firstShard;
+        int lastShard;
+
+        layout.GetReach(x, firstShard, lastShard);
+
+        for (int shard = firstShard; shard <= lastShard; shard++)
+        {
+            if (layout.GetShard(x) == shard || layout.IsGhostOf(shard, x))
+            {
+                m_slabSpawns[shard].push_back(static_cast<unsigned int>(ordinal));
+            }
+        }
+    }
+}
+
+void ShardedSimulation::RunShard(const int aShard, const int aSocket)
+{
+    const SlabLayout layout(m_settings.m_numberOfShards, Simulation::GetSpawnExtent(m_settings.m_distribution));
+    MineManager& manager(MineManager::GetInstance());
+
+    /* Ties must not depend on slot order, which differs from one split to another */
+    manager.SetObjectIdTieBreak(true);
+    manager.SetRandomSeed(m_settings.m_randomSeed);
+    manager.SetTargetingBackend(m_settings.m_targetingBackend);
+    manager.Init(m_settings.m_numberOfTeams, m_settings.m_numberOfMinesPerTeam / m_settings.m_numberOfShards + 1);
+
+    WorkerPool workerPool;
+    workerPool.Start(m_settings.m_numberOfThreadsPerShard);
+
+    Simulation simulation(manager, workerPool, m_settings.m_numberOfTeams);
+
+    /* Only the spawns PartitionSpawns listed for this slab. Object IDs are spawn ordinals, unique across shards */
+    const std::vector<unsigned int>& spawns(m_slabSpawns[aShard]);
+    std::vector<MineRecord> records;
+    /* Own mines other shards keep a ghost of, with the shard keeping it */
+    std::vector<std::pair<int, unsigned int>> boundary;
+
+    records.reserve(spawns.size());
+
+    for (const unsigned int ordinal : spawns)
+    {
+        MineRecord record;
+
+        record.m_objectId = ordinal;
+        record.m_team = static_cast<int>(ordinal) / m_settings.m_numberOfMinesPerTeam;
+        record.m_position = m_spawnPositions[ordinal];
+        MineManager::DrawSpawnProperties(m_settings.m_randomSeed, ordinal, m_settings.m_radiusDistribution, record.m_destructiveRadius, record.m_bitFlags);
+
+        if (layout.GetShard(record.m_position.x) == aShard)
+        {
+            int firstShard;
+            int lastShard;
+
+            layout.GetReach(record.m_position.x, firstShard, lastShard);
+
+            for (int shard = firstShard; shard <= lastShard; shard++)
+            {
+                if (layout.IsGhostOf(shard, record.m_position.x))
+                {
+                    boundary.emplace_back(shard, ordinal);
+                }
+            }
+        }
+        else
+        {
+            record.m_bitFlags |= Mine::OBF_GHOST;
+        }
+
+        records.push_back(record);
+    }
+
+    const int numberOfMinesDropped(static_cast<int>(records.size()) - manager.AddMineRecords(records.data(), static_cast<int>(records.size())));
+
+    std::vector<MineRecord>().swap(records);
+
+    bool running(SendMessage(aSocket, SM_REPLY, 0));
+    std::vector<char> payload;
+    std::vector<unsigned int> removals;
+    std::vector<MineDamage> incomingDamage;
+    std::vector<MineDamage> damage;
+    std::vector<ShardDamage> remoteDamage;
+
+    /* Routes damage dealt to ghosts since last call to the shards owning them */
+    auto collectRemoteDamage = [&manager, &layout, &damage, &remoteDamage]()
+    {
+        manager.TakeRemoteDamage(damage);
+        remoteDamage.clear();
+
+        for (const MineDamage& entry : damage)
+        {
+            const Mine* pGhost(manager.GetObjectByID(static_cast<int>(entry.m_objectId)));
+
+            if (NULL != pGhost)
+            {
+                remoteDamage.push_back({ layout.GetShard(pGhost->GetPosition().x), entry });
+            }
+        }
+    };
+
+    while (running)
+    {
+        MessageHeader header;
+
+        if (!ReceiveMessage(aSocket, header, payload))
+        {
+            break;
+        }
+
+        switch (header.m_type)
+        {
+        case SM_TARGET:
+            DecodePayload(payload, removals);
+
+            for (const unsigned int objectId : removals)
+            {
+                manager.RemoveById(static_cast<int>(objectId));
+            }
+
+            simulation.FindTargets();
+            running = SendMessage(aSocket, SM_REPLY, 0);
+            break;
+        case SM_SELECT:
+        {
+            const Mine* pMine(manager.GetObjectWithMostEnemyTargets(header.m_argument));
+            const ShardBest best = { NULL != pMine ? pMine->GetNumberOfTargets() : 0, NULL != pMine ? pMine->GetObjectId() : 0 };
+
+            running = SendMessage(aSocket, SM_REPLY, 0, std::vector<ShardBest>(1, best));
+            break;
+        }
+        case SM_EXPLODE:
+        {
+            Mine* pMine(manager.GetObjectByID(header.m_argument));
+
+            if (NULL != pMine)
+            {
+                pMine->Explode();
+            }
+
+            collectRemoteDamage();
+            running = SendMessage(aSocket, SM_REPLY, 0, remoteDamage);
+            break;
+        }
+        case SM_DAMAGE:
+            DecodePayload(payload, incomingDamage);
+
+            for (const MineDamage& entry : incomingDamage)
+            {
+                Mine* pMine(manager.GetObjectByID(static_cast<int>(entry.m_objectId)));
+
+                /* Already blown up by an earlier blast, or by another team this turn */
+                if (NULL != pMine && !pMine->IsGhost())
+                {
+                    pMine->TakeDamage(entry.m_damage);
+                }
+            }
+
+            collectRemoteDamage();
+            running = SendMessage(aSocket, SM_REPLY, 0, remoteDamage);
+            break;
+        case SM_END_TURN:
+        {
+            std::vector<ShardRemoval> destroyed;
+
+            for (size_t i = 0; i < boundary.size();)
+            {
+                if (NULL == manager.GetObjectByID(static_cast<int>(boundary[i].second)))
+                {
+                    destroyed.push_back({ boundary[i].first, boundary[i].second });
+                    boundary[i] = boundary.back();
+                    boundary.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+
+            running = SendMessage(aSocket, SM_REPLY, 0, destroyed);
+            break;
+        }
+        case SM_RESULTS:
+        {
+            std::vector<int> results(3 + m_settings.m_numberOfTeams, 0);
+            const MineStorage& storage(manager.GetStorage());
+
+            for (int index = 0; index < storage.GetSize(); index++)
+            {
+                if (storage.m_bitFlags[index] & Mine::OBF_GHOST)
+                {
+                    results[1]++;
+                }
+                else
+                {
+                    results[0]++;
+                    results[3 + storage.m_team[index]]++;
+                }
+            }
+
+            results[2] = numberOfMinesDropped;
+            running = SendMessage(aSocket, SM_REPLY, 0, results);
+            break;
+        }
+        case SM_QUIT:
+        default:
+            running = false;
+            break;
+        }
+    }
+
+    workerPool.Stop();
+    manager.Dispose();
+    close(aSocket);
+}
+#else
+bool ShardedSimulation::Start(const ShardSettings& aSettings)
+{
+    m_settings = aSettings;
+
+    return Fail("only supported on Linux");
+}
+
+bool ShardedSimulation::RunTurn(bool& aTargetsFound)
+{
+    aTargetsFound = false;
+
+    return Fail("only supported on Linux");
+}
+
+bool ShardedSimulation::GetResults(std::vector<ShardResult>& aResults)
+{
+    aResults.clear();
+
+    return Fail("only supported on Linux");
+}
+
+void ShardedSimulation::Stop(void)
+{
+}
+
+void ShardedSimulation::RunShard(const int, const int)
+{
+}
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "MineManager.h"
+#include "Simulation.h"
+#include "SpatialIndex.h"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// How a sharded game is split and what each shard spawns.
+/// </summary>
+struct ShardSettings
+{
+    int m_numberOfShards;
+    /* Worker threads of every shard, jobs run inline if less than one */
+    int m_numberOfThreadsPerShard;
+    int m_numberOfTeams;
+    int m_numberOfMinesPerTeam;
+    unsigned int m_randomSeed;
+    SpawnDistribution m_distribution;
+    RadiusDistribution m_radiusDistribution;
+    TargetingBackend m_targetingBackend;
+};
+
+/// <summary>
+/// What a shard holds at the end of a game.
+/// </summary>
+struct ShardResult
+{
+    int m_numberOfMines;
+    int m_numberOfGhosts;
+    /* Mines that did not fit below cMaximumNumberOfObjects */
+    int m_numberOfMinesDropped;
+    std::vector<int> m_minesPerTeam;
+};
+
+/// <summary>
+/// Game split along the x axis into slabs, each owned by a shard process with a MineManager of its own.
+/// Besides its own mines, a shard holds read only "ghost" copies of the mines of other slabs lying within
+/// cMaxDestructiveRadius of it, so its target lists are complete. This process coordinates: every turn it
+/// has the shards refresh their targets, picks each team best mine across shards, and relays the damage
+/// blasts deal to ghosts to the shard owning them until the chain reaction dies out. Mines destroyed
+/// during a turn are removed from the other shards as ghosts before the next one.
+/// Shards talk to the coordinator only, over Unix domain sockets. Mine IDs are spawn ordinals, unique
+/// without any cross shard bookkeeping, and ties are broken on lowest object ID, so picks do not depend
+/// on the split. Damage is not: a shard applies its own blasts at once and relayed ones when they come
+/// in, so a mine hit from both sides of a slab boundary may sum the same damage in a different order
+/// than with another number of shards, and a mine left at nearly zero health may then survive or go
+/// off. A given split always plays the same game. Linux only.
+/// </summary>
+class ShardedSimulation
+{
+public:
+    ShardedSimulation(void);
+    ~ShardedSimulation(void);
+
+    /// <summary>
+    /// Works out where every spawn lands, then forks shard processes, each of which spawns its slab right
+    /// away. Call before starting any thread.
+    /// </summary>
+    /// <param name="aSettings">const ShardSettings&. Split and field</param>
+    /// <returns>bool. False if shards could not be started, see GetError</returns>
+    bool Start(const ShardSettings& aSettings);
+    /// <summary>
+    /// Plays one turn across every shard.
+    /// </summary>
+    /// <param name="aTargetsFound">bool&. Set if some team found a target, the game goes on</param>
+    /// <returns>bool. False if a shard stopped answering, see GetError</returns>
+    bool RunTurn(bool& aTargetsFound);
+    /// <summary>
+    /// Collects what every shard holds.
+    /// </summary>
+    /// <param name="aResults">std::vector<ShardResult>&. One result per shard, replaced</param>
+    /// <returns>bool. False if a shard stopped answering</returns>
+    bool GetResults(std::vector<ShardResult>& aResults);
+    /// <summary>
+    /// Lets shard processes exit and waits for them. Safe to call more than once.
+    /// </summary>
+    void Stop(void);
+    /// <summary>
+    /// Returns number of turns played.
+    /// </summary>
+    /// <returns>int. Turns</returns>
+    inline int GetNumberOfTurns(void) const { return m_numberOfTurns; }
+    /// <summary>
+    /// Returns why the last call failed.
+    /// </summary>
+    /// <returns>const char*. Reason</returns>
+    inline const char* GetError(void) const { return m_error.c_str(); }
+
+private:
+    /// <summary>
+    /// Draws every spawn position once and lists, per shard, the spawns it owns or keeps a ghost of.
+    /// </summary>
+    void PartitionSpawns(void);
+    /// <summary>
+    /// Shard process body: spawns the slab, then serves coordinator requests until told to quit.
+    /// </summary>
+    /// <param name="aShard">int. Shard index</param>
+    /// <param name="aSocket">int. Socket connected to the coordinator</param>
+    void RunShard(const int aShard, const int aSocket);
+    /// <summary>
+    /// Marks the game as failed.
+    /// </summary>
+    /// <returns>bool. Always false</returns>
+    bool Fail(const char* aReason);
+
+    ShardSettings m_settings;
+    /* Coordinator end of every shard socket, and shard process IDs */
+    std::vector<int> m_sockets;
+    std::vector<int> m_processes;
+    /* Set by PartitionSpawns and inherited by the shard processes, which only walk their own list of
+    ordinals. Released by the coordinator once every shard is forked */
+    std::vector<Vector3> m_spawnPositions;
+    std::vector<std::vector<unsigned int>> m_slabSpawns;
+    /* Ghosts each shard has to drop before its next targeting pass */
+    std::vector<std::vector<unsigned int>> m_pendingRemovals;
+    int m_numberOfTurns;
+    std::string m_error;
+};
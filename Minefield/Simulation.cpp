@@ -0,0 +1,263 @@
+#include "stdafx.h"
+#include "Simulation.h"
+#include "MineManager.h"
+#include "Mine.h"
+#include "Logger.h"
+#include "PerfCounters.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include <math.h>
+#include <string.h>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    const int   cNumberOfSpawnClusters = 8;
+    const float cSpawnClusterDeviation = 75.0f;
+    /* Turn reports stop after the first few turns */
+    const int   cNumberOfReportedTurns = 4;
+
+    const char* const cPhaseNames[SP_COUNT] = { "setup", "targeting", "selection", "explosion" };
+    const char* const cDistributionNames[] = { "uniform", "clustered", "sparse" };
+
+    /// <summary>
+    /// Returns spawn random value in [aMin, aMax], draw number aDraw of spawn aOrdinal.
+    /// </summary>
+    float GetSpawnRandomFloat32_Range(const unsigned int aSeed, const int aOrdinal, const unsigned int aDraw, const float aMin, const float aMax)
+    {
+        return aMin + GetCounterRandomFloat32(aSeed, RS_SPAWN_POSITION, static_cast<unsigned int>(aOrdinal), aDraw) * (aMax - aMin);
+    }
+}
+
+Simulation::Simulation(MineManager& aManager, WorkerPool& aPool, const int aNumberOfTeams) :
+    m_manager(aManager),
+    m_pool(aPool),
+    m_numberOfTeams(aNumberOfTeams),
+    m_numberOfTurns(0)
+{
+    for (int phase = 0; phase < SP_COUNT; phase++)
+    {
+        m_phaseTime[phase] = 0.0;
+    }
+}
+
+Simulation::~Simulation()
+{
+}
+
+int Simulation::SpawnMines(const int aNumberOfMinesPerTeam, const SpawnDistribution aDistribution, const bool aUseHashIDs)
+{
+    m_timer.Start();
+
+    const unsigned int seed(m_manager.GetRandomSeed());
+    std::vector<Vector3> clusterCenters;
+
+    DrawClusterCenters(seed, aDistribution, clusterCenters);
+
+    // Let's add lots of mine objects to the system before starting things up
+    const int firstSlot(m_manager.AddMines(m_numberOfTeams * aNumberOfMinesPerTeam, [seed, &clusterCenters, aNumberOfMinesPerTeam, aDistribution, aUseHashIDs](const int aOrdinal, MineSpawn& aSpawn)
+    {
+        const int team(aOrdinal / aNumberOfMinesPerTeam);
+        const int mine(aOrdinal % aNumberOfMinesPerTeam);
+
+        aSpawn.m_team = team;
+        aSpawn.m_position = GetSpawnPosition(seed, aOrdinal, aDistribution, clusterCenters);
+        aSpawn.m_objectId = aUseHashIDs ?
+            static_cast<unsigned int>(std::hash<unsigned int>()(mine * (team + 1))) :
+            GetCounterRandomUInt32(seed, RS_SPAWN_OBJECT_ID, static_cast<unsigned int>(aOrdinal), 0) % (aNumberOfMinesPerTeam * 10);
+    }, m_pool));
+
+    EndPhase(SP_SETUP);
+
+    return firstSlot;
+}
+
+bool Simulation::RunTurn(void)
+{
+    bool targetsStillFound(false);
+
+    m_numberOfTurns++;
+    m_timer.Start();
+
+    {
+        ProfileScope turnScope(PZ_TURN);
+
+        RunTurnPhases(targetsStillFound);
+    }
+
+    if (Profiler::IsEnabled())
+    {
+        Profiler::EndTurn(m_numberOfTurns);
+    }
+
+    return targetsStillFound;
+}
+
+void Simulation::FindTargets(void)
+{
+    {
+        ProfileScope prepareScope(PZ_PREPARE_TARGETING);
+
+        m_manager.PrepareTargeting(m_pool.GetNumberOfThreads());
+    }
+
+    {
+        ProfileScope targetingScope(PZ_TARGETING);
+
+        // returns once all worker threads have finished doing their thing
+        m_pool.ParallelFor(static_cast<int>(m_manager.GetRetargetQueue().size()), [this](int aBegin, int aEnd, int aThreadIndex)
+        {
+            ProfileScope findTargetsScope(PZ_FIND_TARGETS);
+            PerfCounterScope countersScope(SP_TARGETING);
+            const std::vector<int>& retargetQueue(m_manager.GetRetargetQueue());
+
+            for (int i = aBegin; i < aEnd; ++i)
+            {
+                Mine* pMineObject = m_manager.GetObjectByIndex(retargetQueue[i]);
+
+                if (NULL != pMineObject)
+                {
+                    pMineObject->FindCurrentTargets(aThreadIndex);
+                }
+            }
+        });
+    }
+}
+
+void Simulation::RunTurnPhases(bool& aTargetsFound)
+{
+    FindTargets();
+
+    EndPhase(SP_TARGETING);
+
+    for (int i = 0; i < m_numberOfTeams; i++)
+    {
+        Mine* pMine(NULL);
+
+        {
+            ProfileScope selectionScope(PZ_SELECTION);
+
+            pMine = m_manager.GetObjectWithMostEnemyTargets(i);
+        }
+
+        int enemyTargets = NULL != pMine ? pMine->GetNumberOfTargets() : 0;
+
+        EndPhase(SP_SELECTION);
+
+        if (0 < enemyTargets)
+        {
+            /* Mine slot is reused once exploded */
+            const unsigned int objectId(pMine->GetObjectId());
+
+            {
+                ProfileScope explosionScope(PZ_EXPLOSION);
+                PerfCounterScope countersScope(SP_EXPLOSION);
+
+                pMine->Explode();
+            }
+
+            EndPhase(SP_EXPLOSION);
+
+            aTargetsFound = true;
+
+            if (cNumberOfReportedTurns >= m_numberOfTurns)
+            {
+                LOG_MESSAGE(LL_TURN, "Turn %d: Team %d picks Mine with object id %d (with %d targets) to explode\n", m_numberOfTurns, i,
+                    objectId, enemyTargets);
+            }
+        }
+    }
+}
+
+Vector3 Simulation::GetSpawnPosition(const unsigned int aSeed, const int aOrdinal, const SpawnDistribution aDistribution, const std::vector<Vector3>& aClusterCenters)
+{
+    switch (aDistribution)
+    {
+    case SD_CLUSTERED:
+    {
+        const Vector3& center(aClusterCenters[GetCounterRandomUInt32(aSeed, RS_SPAWN_POSITION, static_cast<unsigned int>(aOrdinal), 0) % cNumberOfSpawnClusters]);
+
+        /* Box-Muller, three normal samples out of two uniform pairs (fourth one dropped) */
+        const float radiusA(sqrtf(-2.0f * logf(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 1, 1e-7f, 1.0f))) * cSpawnClusterDeviation);
+        const float angleA(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 2, 0.0f, 6.2831853f));
+        const float radiusB(sqrtf(-2.0f * logf(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 3, 1e-7f, 1.0f))) * cSpawnClusterDeviation);
+        const float angleB(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 4, 0.0f, 6.2831853f));
+
+        return Vector3(center.x + radiusA * cosf(angleA), center.y + radiusA * sinf(angleA), center.z + radiusB * cosf(angleB));
+    }
+    case SD_SPARSE:
+        return Vector3(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 0, -10000.0f, 10000.0f),
+                       GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 1, -10000.0f, 10000.0f),
+                       GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 2, -10000.0f, 10000.0f));
+    case SD_UNIFORM:
+    default:
+        return Vector3(GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 0, -1000.0f, 1000.0f),
+                       GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 1, -1000.0f, 1000.0f),
+                       GetSpawnRandomFloat32_Range(aSeed, aOrdinal, 2, -1000.0f, 1000.0f));
+    }
+}
+
+void Simulation::DrawClusterCenters(const unsigned int aSeed, const SpawnDistribution aDistribution, std::vector<Vector3>& aClusterCenters)
+{
+    aClusterCenters.clear();
+
+    if (SD_CLUSTERED == aDistribution)
+    {
+        float coordinates[cNumberOfSpawnClusters * 3];
+
+        DrawRandomFloat32_Range(aSeed, -1000.0f, 1000.0f, coordinates, cNumberOfSpawnClusters * 3);
+
+        /* z, y, x: the order the draws used to be evaluated in as constructor arguments, so fields stay the same */
+        for (int i = 0; i < cNumberOfSpawnClusters; i++)
+        {
+            aClusterCenters.emplace_back(coordinates[i * 3 + 2], coordinates[i * 3 + 1], coordinates[i * 3]);
+        }
+    }
+}
+
+float Simulation::GetSpawnExtent(const SpawnDistribution aDistribution)
+{
+    return SD_SPARSE == aDistribution ? 10000.0f : 1000.0f;
+}
+
+int Simulation::GetWinningTeam(const std::vector<int>& aMinesPerTeam)
+{
+    int winningTeam = 0;
+    int winningObjectCount = 0;
+    for (int i = 0; i < static_cast<int>(aMinesPerTeam.size()); i++)
+    {
+        if (aMinesPerTeam[i] > winningObjectCount)
+        {
+            winningObjectCount = aMinesPerTeam[i];
+            winningTeam = i;
+        }
+    }
+
+    return winningTeam;
+}
+
+const char* Simulation::GetPhaseName(const SimulationPhase aPhase)
+{
+    return aPhase >= 0 && aPhase < SP_COUNT ? cPhaseNames[aPhase] : "unknown";
+}
+
+const char* Simulation::GetDistributionName(const SpawnDistribution aDistribution)
+{
+    return aDistribution >= SD_UNIFORM && aDistribution <= SD_SPARSE ? cDistributionNames[aDistribution] : "unknown";
+}
+
+bool Simulation::ParseDistribution(const char* aName, SpawnDistribution& aDistribution)
+{
+    for (int distribution = SD_UNIFORM; distribution <= SD_SPARSE; distribution++)
+    {
+        if (0 == strcmp(aName, cDistributionNames[distribution]))
+        {
+            aDistribution = static_cast<SpawnDistribution>(distribution);
+            return true;
+        }
+    }
+
+    return false;
+}
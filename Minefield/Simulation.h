@@ -0,0 +1,140 @@
+#pragma once
+
+#include "QueryPerformanceTimer.h"
+#include "Object.h"
+#include <vector>
+
+class MineManager;
+class WorkerPool;
+
+/* How spawn positions are laid out */
+enum SpawnDistribution
+{
+    SD_UNIFORM = 0,     // Uniform within a 2000 units box
+    SD_CLUSTERED,       // Gaussian blobs around a few random centers within the same box
+    SD_SPARSE           // Uniform within a 20000 units box
+};
+
+/* Steps of a game, timed separately */
+enum SimulationPhase
+{
+    SP_SETUP = 0,       // Spawning the field
+    SP_TARGETING,       // Target lists of every turn
+    SP_SELECTION,       // Picking the mine each team explodes
+    SP_EXPLOSION,       // Explosions and their chain reactions
+    SP_COUNT
+};
+
+/// <summary>
+/// Runs a game on a mine manager: spawns the field, then plays turns until no team finds a target.
+/// Time spent in every phase is accumulated, so the game itself and the benchmark share the same code.
+/// </summary>
+class Simulation
+{
+public:
+    /// <summary>
+    /// Binds the game to a manager and a started worker pool.
+    /// </summary>
+    /// <param name="aManager">MineManager&. Manager holding the field, initialized</param>
+    /// <param name="aPool">WorkerPool&. Pool targeting and spawning run on</param>
+    /// <param name="aNumberOfTeams">int. Teams picking a mine every turn</param>
+    Simulation(MineManager& aManager, WorkerPool& aPool, const int aNumberOfTeams);
+    ~Simulation(void);
+
+    /// <summary>
+    /// Spawns aNumberOfMinesPerTeam mines for every team. Positions and IDs only depend on the random seed.
+    /// </summary>
+    /// <param name="aNumberOfMinesPerTeam">int. Mines per team</param>
+    /// <param name="aDistribution">SpawnDistribution. Layout of spawn positions</param>
+    /// <param name="aUseHashIDs">bool. Derive IDs from team and mine number instead of drawing them</param>
+    /// <returns>int. Slot of the first mine spawned</returns>
+    int  SpawnMines(const int aNumberOfMinesPerTeam, const SpawnDistribution aDistribution, const bool aUseHashIDs);
+    /// <summary>
+    /// Plays one turn: targeting, then every team in order explodes its mine with most targets.
+    /// </summary>
+    /// <returns>bool. True if some team found a target, the game goes on</returns>
+    bool RunTurn(void);
+    /// <summary>
+    /// Targeting phase alone: refreshes the target lists that need it, on the worker pool.
+    /// </summary>
+    void FindTargets(void);
+    /// <summary>
+    /// Returns number of turns played.
+    /// </summary>
+    /// <returns>int. Turns</returns>
+    inline int GetNumberOfTurns(void) const { return m_numberOfTurns; }
+    /// <summary>
+    /// Returns time spent in a phase so far.
+    /// </summary>
+    /// <param name="aPhase">SimulationPhase. Phase</param>
+    /// <returns>double. Microseconds</returns>
+    inline double GetPhaseTime(const SimulationPhase aPhase) const { return m_phaseTime[aPhase]; }
+
+    /// <summary>
+    /// Returns printable name of a phase.
+    /// </summary>
+    /// <param name="aPhase">SimulationPhase. Phase</param>
+    /// <returns>const char*. Name</returns>
+    static const char* GetPhaseName(const SimulationPhase aPhase);
+    /// <summary>
+    /// Returns command line name of a spawn distribution.
+    /// </summary>
+    /// <param name="aDistribution">SpawnDistribution. Distribution</param>
+    /// <returns>const char*. Name</returns>
+    static const char* GetDistributionName(const SpawnDistribution aDistribution);
+    /// <summary>
+    /// Parses command line name of a spawn distribution.
+    /// </summary>
+    /// <param name="aName">const char*. uniform, clustered or sparse</param>
+    /// <param name="aDistribution">SpawnDistribution&. Parsed distribution, untouched on failure</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseDistribution(const char* aName, SpawnDistribution& aDistribution);
+    /// <summary>
+    /// Draws cluster centers of a distribution, none unless clustered. Centers are the first draws of a
+    /// generator seeded with aSeed, as the global one used to provide them.
+    /// </summary>
+    /// <param name="aSeed">unsigned int. Game seed</param>
+    /// <param name="aDistribution">SpawnDistribution. Distribution</param>
+    /// <param name="aClusterCenters">std::vector<Vector3>&. Centers, replaced</param>
+    static void DrawClusterCenters(const unsigned int aSeed, const SpawnDistribution aDistribution, std::vector<Vector3>& aClusterCenters);
+    /// <summary>
+    /// Returns spawn position of spawn aOrdinal. Only depends on its arguments, so spawns can be
+    /// generated concurrently, or by several processes each keeping a part of them.
+    /// </summary>
+    /// <param name="aSeed">unsigned int. Game seed</param>
+    /// <param name="aOrdinal">int. Spawn ordinal</param>
+    /// <param name="aDistribution">SpawnDistribution. Distribution</param>
+    /// <param name="aClusterCenters">const std::vector<Vector3>&. Centers from DrawClusterCenters</param>
+    /// <returns>Vector3. Position</returns>
+    static Vector3 GetSpawnPosition(const unsigned int aSeed, const int aOrdinal, const SpawnDistribution aDistribution, const std::vector<Vector3>& aClusterCenters);
+    /// <summary>
+    /// Returns half size of the box a distribution spawns in, cluster tails may go past it.
+    /// </summary>
+    /// <param name="aDistribution">SpawnDistribution. Distribution</param>
+    /// <returns>float. Half extent along every axis</returns>
+    static float GetSpawnExtent(const SpawnDistribution aDistribution);
+    /// <summary>
+    /// Returns team with most mines remaining, lowest one on ties.
+    /// </summary>
+    /// <param name="aMinesPerTeam">const std::vector<int>&. Mines remaining, per team</param>
+    /// <returns>int. Winning team, 0 if every team is empty</returns>
+    static int GetWinningTeam(const std::vector<int>& aMinesPerTeam);
+
+private:
+    /// <summary>
+    /// Adds time elapsed since the previous phase boundary to a phase.
+    /// </summary>
+    inline void EndPhase(const SimulationPhase aPhase) { m_phaseTime[aPhase] += m_timer.Get(); }
+    /// <summary>
+    /// Targeting, selection and explosion of the current turn.
+    /// </summary>
+    /// <param name="aTargetsFound">bool&. Set if some team found a target</param>
+    void RunTurnPhases(bool& aTargetsFound);
+
+    MineManager& m_manager;
+    WorkerPool& m_pool;
+    int m_numberOfTeams;
+    int m_numberOfTurns;
+    double m_phaseTime[SP_COUNT];
+    QueryPerformanceTimer m_timer;
+};
@@ -0,0 +1,106 @@
+#include "stdafx.h"
+#include "SpatialGrid.h"
+#include "DistanceKernel.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(const MineStorage& aStorage) :
+    m_storage(aStorage)
+  , m_cellSize(1.0f)
+  , m_inverseCellSize(1.0f)
+{
+}
+
+SpatialGrid::~SpatialGrid()
+{
+}
+
+void SpatialGrid::Init(const float aCellSize)
+{
+    Clear();
+
+    if (aCellSize > 0.0f)
+    {
+        m_cellSize = aCellSize;
+        m_inverseCellSize = 1.0f / aCellSize;
+    }
+    else
+    {
+        STATIC_ASSERT("Invalid cell size")
+    }
+}
+
+void SpatialGrid::Insert(const int aIndex, const Vector3& aPosition)
+{
+    Cell& cell(m_cells[CellKey(aPosition)]);
+
+    cell.m_positionX.push_back(aPosition.x);
+    cell.m_positionY.push_back(aPosition.y);
+    cell.m_positionZ.push_back(aPosition.z);
+    cell.m_index.push_back(aIndex);
+}
+
+void SpatialGrid::Remove(const int aIndex, const Vector3& aPosition)
+{
+    auto it(m_cells.find(CellKey(aPosition)));
+
+    if (std::end(m_cells) != it)
+    {
+        Cell& cell((*it).second);
+
+        const auto& found(std::find(cell.m_index.begin(), cell.m_index.end(), aIndex));
+
+        if (std::end(cell.m_index) != found)
+        {
+            /* Order inside a cell is irrelevant, so swap with last to avoid shifting */
+            const size_t entry(found - cell.m_index.begin());
+
+            cell.m_positionX[entry] = cell.m_positionX.back();
+            cell.m_positionY[entry] = cell.m_positionY.back();
+            cell.m_positionZ[entry] = cell.m_positionZ.back();
+            cell.m_index[entry] = cell.m_index.back();
+
+            cell.m_positionX.pop_back();
+            cell.m_positionY.pop_back();
+            cell.m_positionZ.pop_back();
+            cell.m_index.pop_back();
+        }
+
+        if (cell.m_index.empty())
+        {
+            m_cells.erase(it);
+        }
+    }
+}
+
+void SpatialGrid::Relocate(const int aFrom, const int aTo, const Vector3& aPosition)
+{
+    auto it(m_cells.find(CellKey(aPosition)));
+
+    if (std::end(m_cells) != it)
+    {
+        std::vector<int>& indexes((*it).second.m_index);
+
+        const auto& found(std::find(indexes.begin(), indexes.end(), aFrom));
+
+        if (std::end(indexes) != found)
+        {
+            *found = aTo;
+        }
+    }
+}
+
+void SpatialGrid::Clear(void)
+{
+    m_cells.clear();
+}
+
+void SpatialGrid::QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const
+{
+    const float sqrRadius(aRadius * aRadius);
+    const unsigned char* flags(m_storage.m_bitFlags.data());
+
+    ForEachCellInRadius(aCenter, aRadius, [&](const Cell& aCell) {
+            DistanceKernel::AppendInRadius(aCell.m_positionX.data(), aCell.m_positionY.data(), aCell.m_positionZ.data(), aCell.m_index.data(),
+                                           static_cast<int>(aCell.m_index.size()), aCenter, sqrRadius, flags, aRejectFlags, aOut);
+        });
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "SpatialIndex.h"
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Uniform spatial hash grid used as targeting broadphase. Space is split into cubic cells of
+/// fixed edge length and each cell keeps the mines whose position falls inside it, so a radius
+/// query only visits the cells overlapping the query sphere instead of every object in the system.
+/// </summary>
+class SpatialGrid : public SpatialIndex
+{
+public:
+    SpatialGrid(const MineStorage& aStorage);
+    ~SpatialGrid(void);
+
+    /// <summary>
+    /// Sets cell edge length and drops any previously inserted object.
+    /// </summary>
+    /// <param name="aCellSize">float. Cell edge length, must be greater than zero</param>
+    void Init(const float aCellSize);
+
+    /* Overrided functions */
+    virtual void Insert(const int aIndex, const Vector3& aPosition) override;
+    virtual void Remove(const int aIndex, const Vector3& aPosition) override;
+    virtual void Relocate(const int aFrom, const int aTo, const Vector3& aPosition) override;
+    virtual void Clear(void) override;
+    virtual void QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const override;
+
+    /// <summary>
+    /// Returns cell edge length.
+    /// </summary>
+    /// <returns>float. Cell size</returns>
+    inline float GetCellSize(void) const { return m_cellSize; }
+
+private:
+    /* Cell contents as parallel arrays, so the distance kernel can stream them */
+    struct Cell
+    {
+        std::vector<float> m_positionX;
+        std::vector<float> m_positionY;
+        std::vector<float> m_positionZ;
+        std::vector<int>   m_index;
+    };
+
+    /// <summary>
+    /// Calls aFunc for every non empty cell overlapping the sphere of aRadius around aCenter.
+    /// </summary>
+    /// <param name="aCenter">Vector3. Query center</param>
+    /// <param name="aRadius">float. Query radius</param>
+    /// <param name="aFunc">Callable. Invoked as aFunc(const Cell&)</param>
+    template<typename TFunc>
+    void ForEachCellInRadius(const Vector3& aCenter, const float aRadius, TFunc aFunc) const;
+    /// <summary>
+    /// Returns cell coordinate along one axis.
+    /// </summary>
+    inline int CellCoord(const float aValue) const { return static_cast<int>(floorf(aValue * m_inverseCellSize)); }
+    /// <summary>
+    /// Packs three cell coordinates into a single hash key (21 bits per axis).
+    /// </summary>
+    static inline long long CellKey(const int aX, const int aY, const int aZ)
+    {
+        return ((static_cast<long long>(aX) & 0x1FFFFF) << 42) | ((static_cast<long long>(aY) & 0x1FFFFF) << 21) | (static_cast<long long>(aZ) & 0x1FFFFF);
+    }
+    /// <summary>
+    /// Returns key of the cell containing aPosition.
+    /// </summary>
+    inline long long CellKey(const Vector3& aPosition) const { return CellKey(CellCoord(aPosition.x), CellCoord(aPosition.y), CellCoord(aPosition.z)); }
+
+    const MineStorage& m_storage;
+    float m_cellSize;
+    float m_inverseCellSize;
+    std::unordered_map<long long, Cell> m_cells;
+};
+
+template<typename TFunc>
+void SpatialGrid::ForEachCellInRadius(const Vector3& aCenter, const float aRadius, TFunc aFunc) const
+{
+    const float sqrRadius(aRadius * aRadius);
+
+    const int minX(CellCoord(aCenter.x - aRadius)), maxX(CellCoord(aCenter.x + aRadius));
+    const int minY(CellCoord(aCenter.y - aRadius)), maxY(CellCoord(aCenter.y + aRadius));
+    const int minZ(CellCoord(aCenter.z - aRadius)), maxZ(CellCoord(aCenter.z + aRadius));
+
+    for (int x = minX; x <= maxX; ++x)
+    {
+        /* Distance from center to the closest point of the cell, per axis. Zero when center is inside the slab */
+        const float cellMinX(x * m_cellSize);
+        const float dx(aCenter.x < cellMinX ? cellMinX - aCenter.x : (aCenter.x > cellMinX + m_cellSize ? aCenter.x - cellMinX - m_cellSize : 0.0f));
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            const float cellMinY(y * m_cellSize);
+            const float dy(aCenter.y < cellMinY ? cellMinY - aCenter.y : (aCenter.y > cellMinY + m_cellSize ? aCenter.y - cellMinY - m_cellSize : 0.0f));
+
+            for (int z = minZ; z <= maxZ; ++z)
+            {
+                const float cellMinZ(z * m_cellSize);
+                const float dz(aCenter.z < cellMinZ ? cellMinZ - aCenter.z : (aCenter.z > cellMinZ + m_cellSize ? aCenter.z - cellMinZ - m_cellSize : 0.0f));
+
+                /* Skip corner cells the sphere does not reach */
+                if (dx * dx + dy * dy + dz * dz > sqrRadius)
+                {
+                    continue;
+                }
+
+                const auto cell(m_cells.find(CellKey(x, y, z)));
+
+                if (std::end(m_cells) != cell)
+                {
+                    aFunc((*cell).second);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#include "stdafx.h"
+#include "SpatialIndex.h"
+#include "BruteForceIndex.h"
+#include "SpatialGrid.h"
+#include "KdTree.h"
+#include <string.h>
+
+SpatialIndex* SpatialIndex::Create(const TargetingBackend aBackend, const MineStorage& aStorage, const float aCellSize)
+{
+    SpatialIndex* out_pIndex = NULL;
+
+    switch (aBackend)
+    {
+    case TB_BRUTE_FORCE:
+        out_pIndex = new BruteForceIndex(aStorage);
+        break;
+    case TB_SPATIAL_GRID:
+    {
+        SpatialGrid* pGrid(new SpatialGrid(aStorage));
+        pGrid->Init(aCellSize);
+        out_pIndex = pGrid;
+        break;
+    }
+    case TB_KD_TREE:
+        out_pIndex = new KdTree(aStorage);
+        break;
+    }
+
+    return out_pIndex;
+}
+
+const char* SpatialIndex::GetBackendName(const TargetingBackend aBackend)
+{
+    switch (aBackend)
+    {
+    case TB_BRUTE_FORCE:
+        return "brute";
+    case TB_SPATIAL_GRID:
+        return "grid";
+    case TB_KD_TREE:
+        return "kdtree";
+    }
+
+    return "unknown";
+}
+
+bool SpatialIndex::ParseBackend(const char* aName, TargetingBackend& aOutBackend)
+{
+    const TargetingBackend backends[] = { TB_BRUTE_FORCE, TB_SPATIAL_GRID, TB_KD_TREE };
+
+    for (const TargetingBackend backend : backends)
+    {
+        if (NULL != aName && 0 == strcmp(aName, GetBackendName(backend)))
+        {
+            aOutBackend = backend;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MineStorage.h"
+#include <vector>
+
+/// <summary>
+/// Available broadphase structures answering targeting radius queries.
+/// </summary>
+enum TargetingBackend
+{
+    TB_BRUTE_FORCE = 0,
+    TB_SPATIAL_GRID,
+    TB_KD_TREE
+};
+
+/// <summary>
+/// Abstract broadphase used by MineManager to answer "which mines are within r of p" queries.
+/// Mines are identified by their MineStorage slot index. Implementations are notified of every
+/// insertion, removal and relocation (same mine moved to a different slot) and get a Refresh call
+/// once per turn, before the targeting pass starts.
+/// Queries may run concurrently from worker threads; mutations may not.
+/// </summary>
+class SpatialIndex
+{
+public:
+    virtual ~SpatialIndex(void) {}
+
+    /// <summary>
+    /// Creates broadphase for the requested backend.
+    /// </summary>
+    /// <param name="aBackend">TargetingBackend. Structure to create</param>
+    /// <param name="aStorage">const MineStorage&. Storage slot indexes refer to</param>
+    /// <param name="aCellSize">float. Cell edge length, only used by the spatial grid</param>
+    /// <returns>SpatialIndex*. New instance, owned by caller</returns>
+    static SpatialIndex* Create(const TargetingBackend aBackend, const MineStorage& aStorage, const float aCellSize);
+    /// <summary>
+    /// Returns printable backend name.
+    /// </summary>
+    /// <param name="aBackend">TargetingBackend. Backend</param>
+    /// <returns>const char*. Name, as accepted by ParseBackend</returns>
+    static const char* GetBackendName(const TargetingBackend aBackend);
+    /// <summary>
+    /// Parses backend name (brute, grid, kdtree).
+    /// </summary>
+    /// <param name="aName">const char*. Name to parse</param>
+    /// <param name="aOutBackend">TargetingBackend&. Parsed backend</param>
+    /// <returns>bool. False if name is unknown</returns>
+    static bool ParseBackend(const char* aName, TargetingBackend& aOutBackend);
+
+    /// <summary>
+    /// Registers mine.
+    /// </summary>
+    /// <param name="aIndex">int. Storage slot index</param>
+    /// <param name="aPosition">Vector3. Mine position</param>
+    virtual void Insert(const int aIndex, const Vector3& aPosition) = 0;
+    /// <summary>
+    /// Unregisters mine.
+    /// </summary>
+    /// <param name="aIndex">int. Storage slot index</param>
+    /// <param name="aPosition">Vector3. Mine position</param>
+    virtual void Remove(const int aIndex, const Vector3& aPosition) = 0;
+    /// <summary>
+    /// Updates entry after the mine has been moved to a different storage slot (same position).
+    /// </summary>
+    /// <param name="aFrom">int. Previous slot index</param>
+    /// <param name="aTo">int. New slot index</param>
+    /// <param name="aPosition">Vector3. Mine position</param>
+    virtual void Relocate(const int aFrom, const int aTo, const Vector3& aPosition) = 0;
+    /// <summary>
+    /// Removes all objects.
+    /// </summary>
+    virtual void Clear(void) = 0;
+    /// <summary>
+    /// Brings structure up to date before a targeting pass. Called once per turn.
+    /// </summary>
+    virtual void Refresh(void) {}
+    /// <summary>
+    /// Appends to aOut the slot index of every mine whose position lies within aRadius of aCenter.
+    /// </summary>
+    /// <param name="aCenter">Vector3. Query center</param>
+    /// <param name="aRadius">float. Query radius</param>
+    /// <param name="aRejectFlags">unsigned char. Mines having any of these storage flags set are not reported</param>
+    /// <param name="aOut">std::vector<int>&. Output list, not cleared</param>
+    virtual void QueryRadius(const Vector3& aCenter, const float aRadius, const unsigned char aRejectFlags, std::vector<int>& aOut) const = 0;
+};
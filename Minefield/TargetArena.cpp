@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "TargetArena.h"
+#include <algorithm>
+
+TargetArena::TargetArena() :
+    m_current(0)
+{
+    Reserve(0);
+}
+
+TargetArena::~TargetArena()
+{
+}
+
+void TargetArena::Reserve(const int aNumberOfThreads)
+{
+    const size_t numberOfBuffers(static_cast<size_t>(aNumberOfThreads) + 1);
+
+    /* Never shrinks, spans may point into any buffer. Moved buffers keep their entries and offsets */
+    if (numberOfBuffers > m_buffers[m_current].size())
+    {
+        m_buffers[0].resize(numberOfBuffers);
+        m_buffers[1].resize(numberOfBuffers);
+        m_numberOfReleasedEntries.resize(numberOfBuffers, 0);
+    }
+}
+
+void TargetArena::Encode(const int aBuffer, TargetSpan& aSpan, const unsigned int aHandleClock)
+{
+    if (aSpan.m_count < cTargetBitsetHeaderSize + 1)
+    {
+        return;
+    }
+
+    std::vector<MineHandle>& buffer(m_buffers[m_current][aBuffer]);
+    unsigned int firstEntry(cMineHandleIndexMask);
+    unsigned int lastEntry(0);
+
+    for (unsigned int i = aSpan.m_offset; i < aSpan.m_offset + aSpan.m_count; ++i)
+    {
+        const unsigned int entry(buffer[i] & cMineHandleIndexMask);
+
+        firstEntry = std::min(firstEntry, entry);
+        lastEntry = std::max(lastEntry, entry);
+    }
+
+    const unsigned int firstWord(firstEntry / 32);
+    const unsigned int numberOfEntries(cTargetBitsetHeaderSize + lastEntry / 32 - firstWord + 1);
+
+    if (numberOfEntries >= aSpan.m_count)
+    {
+        return;
+    }
+
+    /* Built past the handles, from capacity the buffer already has once warm, then moved over them */
+    const size_t bitset(buffer.size());
+
+    buffer.resize(bitset + numberOfEntries, 0);
+    buffer[bitset] = firstWord;
+    buffer[bitset + 1] = aHandleClock;
+
+    for (unsigned int i = aSpan.m_offset; i < aSpan.m_offset + aSpan.m_count; ++i)
+    {
+        const unsigned int entry(buffer[i] & cMineHandleIndexMask);
+
+        buffer[bitset + cTargetBitsetHeaderSize + entry / 32 - firstWord] |= 1u << (entry % 32);
+    }
+
+    std::copy(buffer.begin() + bitset, buffer.end(), buffer.begin() + aSpan.m_offset);
+    buffer.resize(aSpan.m_offset + numberOfEntries);
+
+    aSpan.m_count = numberOfEntries;
+    aSpan.m_encoding = TE_BITSET;
+}
+
+size_t TargetArena::GetNumberOfEntries(void) const
+{
+    size_t numberOfEntries(0);
+
+    for (const std::vector<MineHandle>& buffer : m_buffers[m_current])
+    {
+        numberOfEntries += buffer.size();
+    }
+
+    return numberOfEntries;
+}
+
+size_t TargetArena::GetNumberOfReleasedEntries(void) const
+{
+    size_t numberOfEntries(0);
+
+    for (const size_t released : m_numberOfReleasedEntries)
+    {
+        numberOfEntries += released;
+    }
+
+    return numberOfEntries;
+}
+
+void TargetArena::Compact(std::vector<TargetSpan>& aSpans)
+{
+    const int spare(1 - m_current);
+    const unsigned int sequentialBuffer(static_cast<unsigned int>(GetSequentialBuffer()));
+    std::vector<MineHandle>& packed(m_buffers[spare][sequentialBuffer]);
+
+    for (TargetSpan& span : aSpans)
+    {
+        if (0 < span.m_count)
+        {
+            const MineHandle* pEntries(GetEntries(span));
+            const unsigned int offset(static_cast<unsigned int>(packed.size()));
+
+            packed.insert(packed.end(), pEntries, pEntries + span.m_count);
+            span.m_buffer = sequentialBuffer;
+            span.m_offset = offset;
+        }
+    }
+
+    for (std::vector<MineHandle>& buffer : m_buffers[m_current])
+    {
+        buffer.clear();
+    }
+
+    for (size_t& released : m_numberOfReleasedEntries)
+    {
+        released = 0;
+    }
+
+    m_current = spare;
+}
+
+void TargetArena::Clear(void)
+{
+    for (std::vector<MineHandle>& buffer : m_buffers[m_current])
+    {
+        buffer.clear();
+    }
+
+    for (size_t& released : m_numberOfReleasedEntries)
+    {
+        released = 0;
+    }
+}
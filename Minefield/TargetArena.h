@@ -0,0 +1,107 @@
+#pragma once
+
+#include "MineStorage.h"
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// <summary>
+/// Bump allocator for target lists. Each targeting thread appends the lists it builds to a buffer of its
+/// own, one more buffer serving lists built outside passes, and a mine only keeps the TargetSpan its list
+/// landed in. Buffers are cleared, never freed, so once they have grown to their working size targeting
+/// makes no heap allocation at all.
+/// Lists of mines left out of a pass stay where they are, rebuilt ones leave their old entries behind.
+/// Once those outweigh the live ones, Compact packs the live lists into a spare set of buffers and resets
+/// the current one: a reset per pass when every mine is retargeted, and memory bounded to about twice the
+/// live lists when only a few are.
+/// Lists targeting a large share of the field are stored as bitsets over handle table entries instead,
+/// see TargetEncoding: a 32 bit word per 32 entries, whichever mines they hold.
+/// </summary>
+class TargetArena
+{
+public:
+    TargetArena(void);
+    ~TargetArena(void);
+
+    /// <summary>
+    /// Makes sure there is a buffer for each of aNumberOfThreads targeting threads, plus the sequential one.
+    /// Not thread safe, call between passes.
+    /// </summary>
+    /// <param name="aNumberOfThreads">int. Threads appending during a pass</param>
+    void Reserve(const int aNumberOfThreads);
+    /// <summary>
+    /// Returns buffer the lists built outside targeting passes go to.
+    /// </summary>
+    /// <returns>int. Buffer index</returns>
+    inline int GetSequentialBuffer(void) const { return static_cast<int>(m_buffers[m_current].size()) - 1; }
+    /// <summary>
+    /// Returns buffer to append to. Only one thread may append to a given buffer at a time.
+    /// </summary>
+    /// <param name="aBuffer">int. Buffer index, the thread index during passes</param>
+    /// <returns>std::vector<MineHandle>&. Buffer, entries past the current size are free</returns>
+    inline std::vector<MineHandle>& GetBuffer(const int aBuffer) { return m_buffers[m_current][aBuffer]; }
+    /// <summary>
+    /// Turns a list of handles, last appended to aBuffer, into a bitset if that takes fewer entries.
+    /// </summary>
+    /// <param name="aBuffer">int. Buffer of the calling thread</param>
+    /// <param name="aSpan">TargetSpan&. List, updated when encoded</param>
+    /// <param name="aHandleClock">unsigned int. MineStorage::GetHandleClock() when the list was built</param>
+    void Encode(const int aBuffer, TargetSpan& aSpan, const unsigned int aHandleClock);
+    /// <summary>
+    /// Returns first entry of a list. Only valid until its buffer is appended to.
+    /// </summary>
+    /// <param name="aSpan">const TargetSpan&. List</param>
+    /// <returns>const MineHandle*. Entries, aSpan.m_count of them, handles or bitset words</returns>
+    inline const MineHandle* GetEntries(const TargetSpan& aSpan) const { return m_buffers[m_current][aSpan.m_buffer].data() + aSpan.m_offset; }
+    /// <summary>
+    /// Records that a list is no longer referenced. Counted per buffer, like appending.
+    /// </summary>
+    /// <param name="aBuffer">int. Buffer of the calling thread</param>
+    /// <param name="aSpan">const TargetSpan&. Dropped list</param>
+    inline void Release(const int aBuffer, const TargetSpan& aSpan) { m_numberOfReleasedEntries[aBuffer] += aSpan.m_count; }
+    /// <summary>
+    /// Returns number of entries appended since the last reset.
+    /// </summary>
+    /// <returns>size_t. Entries, released ones included</returns>
+    size_t GetNumberOfEntries(void) const;
+    /// <summary>
+    /// Returns number of entries no longer referenced.
+    /// </summary>
+    /// <returns>size_t. Released entries</returns>
+    size_t GetNumberOfReleasedEntries(void) const;
+    /// <summary>
+    /// Moves every non empty list into the spare buffers, packed into the sequential one, and resets the
+    /// others. Spans are updated in place. Not thread safe, call between passes.
+    /// </summary>
+    /// <param name="aSpans">std::vector<TargetSpan>&. Every list still referenced, empty ones skipped</param>
+    void Compact(std::vector<TargetSpan>& aSpans);
+    /// <summary>
+    /// Drops every list, keeping allocated memory.
+    /// </summary>
+    void Clear(void);
+    /// <summary>
+    /// Returns index of the lowest bit set, for walking bitset words.
+    /// </summary>
+    /// <param name="aBits">unsigned int. Word, not 0</param>
+    /// <returns>unsigned int. Bit index</returns>
+    static inline unsigned int GetLowestBit(const unsigned int aBits)
+    {
+#ifdef _MSC_VER
+        unsigned long bit;
+
+        _BitScanForward(&bit, aBits);
+
+        return bit;
+#else
+        return __builtin_ctz(aBits);
+#endif
+    }
+
+private:
+    /* Current and spare buffer sets, both with the same number of buffers */
+    std::vector<std::vector<MineHandle>> m_buffers[2];
+    int m_current;
+    /* Per buffer, so concurrent threads never write the same counter */
+    std::vector<size_t> m_numberOfReleasedEntries;
+};
@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "TargetRanking.h"
+
+TargetRanking::TargetRanking(const MineStorage& aStorage) :
+    m_storage(aStorage),
+    m_objectIdTieBreak(false)
+{
+}
+
+TargetRanking::~TargetRanking()
+{
+}
+
+void TargetRanking::Insert(const int aIndex)
+{
+    if (aIndex >= static_cast<int>(m_heapPosition.size()))
+    {
+        m_heapPosition.resize(aIndex + 1, -1);
+        m_key.resize(aIndex + 1, 0);
+    }
+
+    ReadKey(aIndex);
+
+    std::vector<int>& heap(m_heaps[m_storage.m_team[aIndex]]);
+
+    heap.push_back(aIndex);
+    m_heapPosition[aIndex] = static_cast<int>(heap.size()) - 1;
+
+    SiftUp(heap, m_heapPosition[aIndex]);
+}
+
+void TargetRanking::Remove(const int aIndex)
+{
+    if (aIndex < static_cast<int>(m_heapPosition.size()) && m_heapPosition[aIndex] >= 0)
+    {
+        std::vector<int>& heap(m_heaps[m_storage.m_team[aIndex]]);
+
+        const int position(m_heapPosition[aIndex]);
+        const int last(heap.back());
+
+        heap.pop_back();
+        m_heapPosition[aIndex] = -1;
+
+        /* Fill the hole with the last leaf and let it find its place either way */
+        if (last != aIndex)
+        {
+            Place(heap, position, last);
+            SiftUp(heap, position);
+            SiftDown(heap, m_heapPosition[last]);
+        }
+    }
+}
+
+void TargetRanking::Relocate(const int aFrom, const int aTo)
+{
+    if (aFrom < static_cast<int>(m_heapPosition.size()) && m_heapPosition[aFrom] >= 0)
+    {
+        std::vector<int>& heap(m_heaps[m_storage.m_team[aTo]]);
+
+        const int position(m_heapPosition[aFrom]);
+
+        m_heapPosition[aFrom] = -1;
+        m_key[aTo] = m_key[aFrom];
+        Place(heap, position, aTo);
+
+        /* Storage only ever moves mines to a lower slot, which can only improve their tie-break (object IDs move along) */
+        SiftUp(heap, position);
+    }
+}
+
+void TargetRanking::Update(const int aIndex)
+{
+    if (aIndex < static_cast<int>(m_heapPosition.size()) && m_heapPosition[aIndex] >= 0)
+    {
+        std::vector<int>& heap(m_heaps[m_storage.m_team[aIndex]]);
+
+        ReadKey(aIndex);
+        SiftUp(heap, m_heapPosition[aIndex]);
+        SiftDown(heap, m_heapPosition[aIndex]);
+    }
+}
+
+void TargetRanking::Rebuild(void)
+{
+    for (auto& team : m_heaps)
+    {
+        std::vector<int>& heap(team.second);
+
+        for (const int index : heap)
+        {
+            ReadKey(index);
+        }
+
+        for (int position = static_cast<int>(heap.size()) / 2 - 1; position >= 0; --position)
+        {
+            SiftDown(heap, position);
+        }
+    }
+}
+
+void TargetRanking::Clear(void)
+{
+    m_heaps.clear();
+    m_heapPosition.clear();
+    m_key.clear();
+}
+
+int TargetRanking::GetTop(const int aTeam) const
+{
+    const auto heap(m_heaps.find(aTeam));
+
+    return std::end(m_heaps) != heap && !(*heap).second.empty() ? (*heap).second.front() : -1;
+}
+
+void TargetRanking::SiftUp(std::vector<int>& aHeap, int aPosition)
+{
+    const int index(aHeap[aPosition]);
+
+    while (aPosition > 0)
+    {
+        const int parent((aPosition - 1) / 2);
+
+        if (!IsBefore(index, aHeap[parent]))
+        {
+            break;
+        }
+
+        Place(aHeap, aPosition, aHeap[parent]);
+        aPosition = parent;
+    }
+
+    Place(aHeap, aPosition, index);
+}
+
+void TargetRanking::SiftDown(std::vector<int>& aHeap, int aPosition)
+{
+    const int size(static_cast<int>(aHeap.size()));
+    const int index(aHeap[aPosition]);
+
+    for (;;)
+    {
+        int child(2 * aPosition + 1);
+
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && IsBefore(aHeap[child + 1], aHeap[child]))
+        {
+            child++;
+        }
+        if (!IsBefore(aHeap[child], index))
+        {
+            break;
+        }
+
+        Place(aHeap, aPosition, aHeap[child]);
+        aPosition = child;
+    }
+
+    Place(aHeap, aPosition, index);
+}
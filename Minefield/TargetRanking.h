@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MineStorage.h"
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Per team indexed binary max-heap of storage slots ordered by number of targets, lowest slot first
+/// on ties, so the mine a team explodes next is always at the top. Every slot knows its heap position,
+/// which lets a single mine be re-sorted, removed or renumbered in O(log n) instead of rescanning
+/// the team.
+/// Keys are snapshots of the storage target list sizes, taken on Insert, Update and Rebuild, so lists
+/// may change freely as long as Update (or Rebuild) is called before the ranking is read again.
+/// </summary>
+class TargetRanking
+{
+public:
+    TargetRanking(const MineStorage& aStorage);
+    ~TargetRanking(void);
+
+    /// <summary>
+    /// Adds slot to its team heap.
+    /// </summary>
+    /// <param name="aIndex">int. Storage slot index</param>
+    void Insert(const int aIndex);
+    /// <summary>
+    /// Removes slot from its team heap. Call before the storage slot is released.
+    /// </summary>
+    /// <param name="aIndex">int. Storage slot index</param>
+    void Remove(const int aIndex);
+    /// <summary>
+    /// Renumbers entry after the mine has been moved to a different storage slot. Call after the move.
+    /// </summary>
+    /// <param name="aFrom">int. Previous slot index</param>
+    /// <param name="aTo">int. New slot index</param>
+    void Relocate(const int aFrom, const int aTo);
+    /// <summary>
+    /// Restores heap order after slot number of targets changed.
+    /// </summary>
+    /// <param name="aIndex">int. Storage slot index</param>
+    void Update(const int aIndex);
+    /// <summary>
+    /// Heapifies every team from scratch, O(n). Cheaper than Update once most keys changed.
+    /// </summary>
+    void Rebuild(void);
+    /// <summary>
+    /// Removes all entries.
+    /// </summary>
+    void Clear(void);
+    /// <summary>
+    /// Returns slot with most targets of a team, lowest slot on ties.
+    /// </summary>
+    /// <param name="aTeam">int. Team ID</param>
+    /// <returns>int. Slot index, -1 if team has no mines</returns>
+    int  GetTop(const int aTeam) const;
+    /// <summary>
+    /// Breaks ties on lowest object ID instead of lowest slot. Slots depend on removal history, object IDs
+    /// do not, so rankings split across several managers agree with each other. Call while empty.
+    /// </summary>
+    /// <param name="aEnabled">bool. Object ID or slot</param>
+    inline void SetObjectIdTieBreak(const bool aEnabled) { m_objectIdTieBreak = aEnabled; }
+
+private:
+    /// <summary>
+    /// Heap order: more targets first, then lower slot (or object ID).
+    /// </summary>
+    inline bool IsBefore(const int aLeft, const int aRight) const
+    {
+        return m_key[aLeft] > m_key[aRight] || (m_key[aLeft] == m_key[aRight] &&
+            (m_objectIdTieBreak ? m_storage.m_objectId[aLeft] < m_storage.m_objectId[aRight] : aLeft < aRight));
+    }
+    /// <summary>
+    /// Takes key snapshot of a slot.
+    /// </summary>
+    inline void ReadKey(const int aIndex) { m_key[aIndex] = m_storage.m_numberOfTargets[aIndex]; }
+    /// <summary>
+    /// Moves heap entry at aPosition towards the root while it beats its parent.
+    /// </summary>
+    void SiftUp(std::vector<int>& aHeap, int aPosition);
+    /// <summary>
+    /// Moves heap entry at aPosition towards the leaves while a child beats it.
+    /// </summary>
+    void SiftDown(std::vector<int>& aHeap, int aPosition);
+    /// <summary>
+    /// Stores slot at heap position, keeping the reverse lookup in sync.
+    /// </summary>
+    inline void Place(std::vector<int>& aHeap, const int aPosition, const int aIndex)
+    {
+        aHeap[aPosition] = aIndex;
+        m_heapPosition[aIndex] = aPosition;
+    }
+
+    const MineStorage& m_storage;
+    std::unordered_map<int, std::vector<int>> m_heaps;
+    /* Heap position of every storage slot, -1 if not ranked */
+    std::vector<int> m_heapPosition;
+    /* Number of targets of every storage slot when last read */
+    std::vector<int> m_key;
+    bool m_objectIdTieBreak;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <math.h>
+#include <string.h>
 /*
     __linux__       Defined on Linux
     __unix__        Defined on Unit OS
@@ -15,6 +16,17 @@
     _WIN32          Defined on Windows
 */
 
+template<typename TTo, typename TFrom>
+TTo Reinterprete_Cast(const TFrom in_value)
+{
+    static_assert(sizeof(TTo) == sizeof(TFrom), "Reinterprete_Cast requires types of the same size");
+
+    TTo out_value;
+    memcpy(&out_value, &in_value, sizeof(TTo));
+
+    return out_value;
+}
+
 template<typename t>
 t safediv(t in_tI, t in_tJ, t in_tDefault)
 {
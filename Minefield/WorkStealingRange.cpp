@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "WorkStealingRange.h"
+#include <algorithm>
+
+namespace
+{
+    /* Guided chunking: take 1/cChunkDivisor of what is left, within [cMinChunkSize, cMaxChunkSize] */
+    const int cChunkDivisor = 4;
+    const int cMinChunkSize = 16;
+    const int cMaxChunkSize = 512;
+}
+
+WorkStealingRange::WorkStealingRange() :
+    m_numberOfWorkers(0)
+  , m_capacity(0)
+{
+}
+
+WorkStealingRange::~WorkStealingRange()
+{
+}
+
+void WorkStealingRange::Reset(const int aNumberOfItems, const int aNumberOfWorkers)
+{
+    const int numberOfWorkers(std::max(aNumberOfWorkers, 1));
+
+    if (numberOfWorkers > m_capacity)
+    {
+        m_slices.reset(new Slice[numberOfWorkers]);
+        m_capacity = numberOfWorkers;
+    }
+
+    m_numberOfWorkers = numberOfWorkers;
+
+    for (int i = 0; i < numberOfWorkers; i++)
+    {
+        m_slices[i].m_begin = static_cast<int>(static_cast<long long>(aNumberOfItems) * i / numberOfWorkers);
+        m_slices[i].m_end = static_cast<int>(static_cast<long long>(aNumberOfItems) * (i + 1) / numberOfWorkers);
+    }
+}
+
+bool WorkStealingRange::Next(const int aWorker, int& aOutBegin, int& aOutEnd)
+{
+    Slice& slice(m_slices[aWorker]);
+
+    do
+    {
+        MutexLock lock(slice.m_lock);
+
+        const int remaining(slice.m_end - slice.m_begin);
+
+        if (remaining > 0)
+        {
+            const int chunk(std::min(remaining, std::min(std::max(remaining / cChunkDivisor, cMinChunkSize), cMaxChunkSize)));
+
+            aOutBegin = slice.m_begin;
+            aOutEnd = slice.m_begin + chunk;
+            slice.m_begin = aOutEnd;
+
+            return true;
+        }
+    } while (Steal(aWorker));
+
+    return false;
+}
+
+bool WorkStealingRange::Steal(const int aWorker)
+{
+    for (int i = 1; i < m_numberOfWorkers; i++)
+    {
+        Slice& victim(m_slices[(aWorker + i) % m_numberOfWorkers]);
+
+        int begin(0);
+        int end(0);
+
+        {
+            MutexLock lock(victim.m_lock);
+
+            const int remaining(victim.m_end - victim.m_begin);
+
+            if (remaining <= 0)
+            {
+                continue;
+            }
+
+            /* Back half, or everything when too small to be worth splitting */
+            const int kept(remaining > cMinChunkSize ? remaining / 2 : 0);
+
+            begin = victim.m_begin + kept;
+            end = victim.m_end;
+            victim.m_end = begin;
+        }
+
+        /* Own slice is empty and only its owner refills it, so no other worker can be racing here */
+        Slice& slice(m_slices[aWorker]);
+        MutexLock lock(slice.m_lock);
+
+        slice.m_begin = begin;
+        slice.m_end = end;
+
+        return true;
+    }
+
+    return false;
+}
+
+MutexStatistics WorkStealingRange::GetLockStatistics(void) const
+{
+    MutexStatistics out_statistics = { 0, 0, 0 };
+
+    for (int i = 0; i < m_capacity; i++)
+    {
+        const MutexStatistics slice(m_slices[i].m_lock.GetStatistics());
+
+        out_statistics.m_acquisitions += slice.m_acquisitions;
+        out_statistics.m_contendedAcquisitions += slice.m_contendedAcquisitions;
+        out_statistics.m_waitNanoseconds += slice.m_waitNanoseconds;
+    }
+
+    return out_statistics;
+}
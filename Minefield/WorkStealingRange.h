@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Mutex.h"
+#include <memory>
+
+/// <summary>
+/// Hands out an index range [0, N) to several workers in chunks. Every worker starts owning an equal
+/// slice and takes guided chunks (a fraction of what is left, clamped) from its front; once empty it
+/// steals the back half of the next non-empty slice. Workers only touch their own slice lock in the
+/// common case, so there is no global counter bouncing between cores, and slices that turn out to be
+/// expensive (dense regions with many candidates per mine) get split up by the idle workers.
+/// </summary>
+class WorkStealingRange
+{
+public:
+    WorkStealingRange(void);
+    ~WorkStealingRange(void);
+
+    /// <summary>
+    /// Splits [0, aNumberOfItems) evenly among workers. Not thread safe, call before the workers start.
+    /// </summary>
+    /// <param name="aNumberOfItems">int. Range size</param>
+    /// <param name="aNumberOfWorkers">int. Number of workers calling Next</param>
+    void Reset(const int aNumberOfItems, const int aNumberOfWorkers);
+    /// <summary>
+    /// Returns next chunk for a worker, stealing from others once its own slice is exhausted.
+    /// </summary>
+    /// <param name="aWorker">int. Worker index, in [0, aNumberOfWorkers)</param>
+    /// <param name="aOutBegin">int&. First index of the chunk</param>
+    /// <param name="aOutEnd">int&. One past the last index of the chunk</param>
+    /// <returns>bool. False once the whole range has been handed out</returns>
+    bool Next(const int aWorker, int& aOutBegin, int& aOutEnd);
+    /// <summary>
+    /// Returns counters of all slice locks added together.
+    /// </summary>
+    /// <returns>MutexStatistics. Slice lock counters</returns>
+    MutexStatistics GetLockStatistics(void) const;
+
+private:
+    struct Slice
+    {
+        Mutex m_lock;
+        int m_begin;
+        int m_end;
+        /* Keeps neighbouring slices off the same cache line so owners do not false-share (C++14 new
+        does not honour alignas beyond the default alignment) */
+        char m_padding[64];
+    };
+
+    /// <summary>
+    /// Moves the back half of some other slice into aWorker's slice.
+    /// </summary>
+    /// <returns>bool. False if there was nothing left to steal</returns>
+    bool Steal(const int aWorker);
+
+    std::unique_ptr<Slice[]> m_slices;
+    int m_numberOfWorkers;
+    int m_capacity;
+};
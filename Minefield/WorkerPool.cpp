@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+WorkerPool::WorkerPool() :
+    m_pJob(NULL)
+  , m_dispatchTime(0.0)
+  , m_generation(0)
+  , m_numberOfThreadsRunning(0)
+  , m_stopping(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    Stop();
+}
+
+void WorkerPool::Start(const int aNumberOfThreads)
+{
+    Stop();
+
+    m_stopping = false;
+    m_threads.reserve(aNumberOfThreads > 0 ? aNumberOfThreads : 0);
+
+    for (int i = 0; i < aNumberOfThreads; i++)
+    {
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this, i, m_generation);
+    }
+}
+
+void WorkerPool::Stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stopping = true;
+    }
+
+    m_jobReady.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+
+    m_threads.clear();
+}
+
+void WorkerPool::Execute(const std::function<void(int)>& aJob)
+{
+    if (m_threads.empty())
+    {
+        aJob(0);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_pJob = &aJob;
+    m_dispatchTime = Profiler::IsEnabled() ? QueryPerformanceTimer::Now() : 0.0;
+    m_numberOfThreadsRunning = static_cast<int>(m_threads.size());
+    m_generation++;
+
+    m_jobReady.notify_all();
+
+    m_jobDone.wait(lock, [this]() { return 0 == m_numberOfThreadsRunning; });
+
+    m_pJob = NULL;
+}
+
+void WorkerPool::ParallelFor(const int aNumberOfItems, const std::function<void(int, int, int)>& aFunc)
+{
+    m_range.Reset(aNumberOfItems, GetNumberOfThreads());
+
+    Execute([&](const int aThreadIndex) {
+            int begin(0);
+            int end(0);
+
+            while (m_range.Next(aThreadIndex, begin, end))
+            {
+                aFunc(begin, end, aThreadIndex);
+            }
+        });
+}
+
+void WorkerPool::WorkerLoop(const int aThreadIndex, const unsigned int aGeneration)
+{
+    unsigned int lastGeneration(aGeneration);
+
+    for (;;)
+    {
+        const std::function<void(int)>* pJob(NULL);
+        double dispatchTime(0.0);
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            m_jobReady.wait(lock, [&]() { return m_stopping || m_generation != lastGeneration; });
+
+            if (m_stopping)
+            {
+                return;
+            }
+
+            lastGeneration = m_generation;
+            pJob = m_pJob;
+            dispatchTime = m_dispatchTime;
+        }
+
+        if (Profiler::IsEnabled())
+        {
+            Profiler::AddSample(PZ_WORKER_WAKEUP, QueryPerformanceTimer::Now() - dispatchTime);
+        }
+
+        (*pJob)(aThreadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            if (0 == --m_numberOfThreadsRunning)
+            {
+                m_jobDone.notify_one();
+            }
+        }
+    }
+}
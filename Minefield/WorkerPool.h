@@ -0,0 +1,75 @@
+#pragma once
+
+#include "WorkStealingRange.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Persistent pool of worker threads. Threads are created once and sleep on a condition variable
+/// between jobs; Execute wakes all of them, runs the job on each one and blocks until the last
+/// worker is done, so every call doubles as a completion barrier.
+/// </summary>
+class WorkerPool
+{
+public:
+    WorkerPool(void);
+    ~WorkerPool(void);
+
+    /// <summary>
+    /// Spawns worker threads. Any previous pool is stopped first.
+    /// </summary>
+    /// <param name="aNumberOfThreads">int. Number of workers, jobs run on the calling thread if less than one</param>
+    void Start(const int aNumberOfThreads);
+    /// <summary>
+    /// Wakes workers up, lets them exit and joins them. Safe to call more than once.
+    /// </summary>
+    void Stop(void);
+    /// <summary>
+    /// Runs aJob once on every worker and waits for all of them to return. Must not be called from
+    /// inside a job.
+    /// </summary>
+    /// <param name="aJob">std::function<void(int)>. Invoked with the worker index, in [0, GetNumberOfThreads())</param>
+    void Execute(const std::function<void(int)>& aJob);
+    /// <summary>
+    /// Splits [0, aNumberOfItems) in chunks balanced across workers by work stealing and waits for
+    /// all of them to be processed. Must not be called from inside a job.
+    /// </summary>
+    /// <param name="aNumberOfItems">int. Range size</param>
+    /// <param name="aFunc">std::function<void(int, int, int)>. Invoked as aFunc(begin, end, workerIndex) per chunk</param>
+    void ParallelFor(const int aNumberOfItems, const std::function<void(int, int, int)>& aFunc);
+
+    /// <summary>
+    /// Returns number of workers a job is split across.
+    /// </summary>
+    /// <returns>int. Number of threads, 1 when jobs run on the calling thread</returns>
+    inline int GetNumberOfThreads(void) const { return m_threads.empty() ? 1 : static_cast<int>(m_threads.size()); }
+    /// <summary>
+    /// Returns lock counters of the ParallelFor scheduler.
+    /// </summary>
+    /// <returns>MutexStatistics. Scheduler lock counters</returns>
+    inline MutexStatistics GetSchedulerLockStatistics(void) const { return m_range.GetLockStatistics(); }
+
+private:
+    /// <summary>
+    /// Worker thread body: waits for a new generation, runs the job, reports completion.
+    /// </summary>
+    /// <param name="aThreadIndex">int. Worker index</param>
+    /// <param name="aGeneration">unsigned int. Generation at spawn time, only later jobs are run</param>
+    void WorkerLoop(const int aThreadIndex, const unsigned int aGeneration);
+
+    std::vector<std::thread> m_threads;
+    WorkStealingRange m_range;
+    std::mutex m_lock;
+    std::condition_variable m_jobReady;
+    std::condition_variable m_jobDone;
+    const std::function<void(int)>* m_pJob;
+    /* QueryPerformanceTimer::Now when the current job was handed out, only set while profiling */
+    double m_dispatchTime;
+    /* Bumped on every Execute, workers run the job once per generation */
+    unsigned int m_generation;
+    int m_numberOfThreadsRunning;
+    bool m_stopping;
+};